@@ -0,0 +1,193 @@
+#include "catalog.h"
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+static int grow_column(void** column, size_t item_size, uint32_t capacity) {
+	void *ret = realloc(*column, capacity * item_size);
+	if (ret == NULL) {
+		return -1;
+	}
+	*column = ret;
+	return 0;
+}
+static int catalog_grow(struct catalog_t* pcatalog) {
+	uint32_t capacity = pcatalog->capacity ? pcatalog->capacity * 2 : 256;
+	if (   grow_column((void **)&pcatalog->paths, sizeof(char *), capacity) != 0
+		|| grow_column((void **)&pcatalog->names, sizeof(char[13]), capacity) != 0
+		|| grow_column((void **)&pcatalog->sizes, sizeof(uint32_t), capacity) != 0
+		|| grow_column((void **)&pcatalog->attributes, sizeof(uint8_t), capacity) != 0
+		|| grow_column((void **)&pcatalog->clusters, sizeof(uint16_t), capacity) != 0
+		|| grow_column((void **)&pcatalog->created, sizeof(uint32_t), capacity) != 0
+		|| grow_column((void **)&pcatalog->modified, sizeof(uint32_t), capacity) != 0
+		|| grow_column((void **)&pcatalog->accessed, sizeof(uint32_t), capacity) != 0
+		|| grow_column((void **)&pcatalog->created_tenth, sizeof(uint8_t), capacity) != 0) {
+		errno = ENOMEM;
+		return -1;
+	}
+	pcatalog->capacity = capacity;
+	return 0;
+}
+static int catalog_add(const struct walk_entry_t* pentry, void* arg) {
+	struct catalog_t *pcatalog = (struct catalog_t *)arg;
+	if (pcatalog->size == pcatalog->capacity && catalog_grow(pcatalog) != 0) {
+		return -1;
+	}
+	uint32_t i = pcatalog->size;
+	char *path = malloc(strlen(pentry->path) + 1);
+	if (path == NULL) {
+		errno = ENOMEM;
+		return -1;
+	}
+	strcpy(path, pentry->path);
+	*(pcatalog->paths + i) = path;
+	strcpy(*(pcatalog->names + i), pentry->name);
+	*(pcatalog->sizes + i) = pentry->raw.DIR_FileSize;
+	memcpy(pcatalog->attributes + i, &pentry->raw.DIR_Attr, sizeof(uint8_t));
+	*(pcatalog->clusters + i) = pentry->raw.DIR_FstClusLO;
+	*(pcatalog->created + i) = (uint32_t)pentry->raw.DIR_CrtDate.date << 16 | pentry->raw.DIR_CrtTime.time;
+	*(pcatalog->modified + i) = (uint32_t)pentry->raw.DIR_WrtDate.date << 16 | pentry->raw.DIR_WrtTime.time;
+	*(pcatalog->accessed + i) = (uint32_t)pentry->raw.DIR_LstAccDate.date << 16;
+	*(pcatalog->created_tenth + i) = pentry->raw.DIR_CrtTimeTenth;
+	pcatalog->size++;
+	return 0;
+}
+struct catalog_t* catalog_open(struct volume_t* pvolume) {
+	if (pvolume == NULL || pvolume->FAT1 == NULL) {
+		errno = EFAULT;
+		return NULL;
+	}
+	struct catalog_t *pcatalog = calloc(1, sizeof(struct catalog_t));
+	if (pcatalog == NULL) {
+		errno = ENOMEM;
+		return NULL;
+	}
+	pcatalog->pvolume = pvolume;
+	if (volume_walk(pvolume, 0, catalog_add, pcatalog) != 0) {
+		catalog_close(pcatalog);
+		return NULL;
+	}
+	return pcatalog;
+}
+int catalog_close(struct catalog_t* pcatalog) {
+	if (pcatalog == NULL) {
+		errno = EFAULT;
+		return -1;
+	}
+	for (uint32_t i = 0; i < pcatalog->size; ++i) {
+		free(*(pcatalog->paths + i));
+	}
+	free(pcatalog->paths);
+	free(pcatalog->names);
+	free(pcatalog->sizes);
+	free(pcatalog->attributes);
+	free(pcatalog->clusters);
+	free(pcatalog->created);
+	free(pcatalog->modified);
+	free(pcatalog->accessed);
+	free(pcatalog->created_tenth);
+	free(pcatalog);
+	return 0;
+}
+int catalog_entry(const struct catalog_t* pcatalog, uint32_t index, struct dir_entry_t* pentry) {
+	if (pcatalog == NULL || pentry == NULL) {
+		errno = EFAULT;
+		return -1;
+	}
+	if (index >= pcatalog->size) {
+		errno = EINVAL;
+		return -1;
+	}
+	// REBUILD RAW ENTRY FROM COLUMNS
+	struct actual_dir_entry_t ent;
+	memset(&ent, 0, sizeof(ent));
+	memcpy(&ent.DIR_Attr, pcatalog->attributes + index, sizeof(uint8_t));
+	ent.DIR_CrtDate.date = *(pcatalog->created + index) >> 16;
+	ent.DIR_CrtTime.time = *(pcatalog->created + index) & 0xFFFF;
+	ent.DIR_WrtDate.date = *(pcatalog->modified + index) >> 16;
+	ent.DIR_WrtTime.time = *(pcatalog->modified + index) & 0xFFFF;
+	ent.DIR_LstAccDate.date = *(pcatalog->accessed + index) >> 16;
+	ent.DIR_CrtTimeTenth = *(pcatalog->created_tenth + index);
+	struct time_format_t midnight = { .time = 0 };
+
+	strcpy(pentry->name, *(pcatalog->names + index));
+	pentry->size = *(pcatalog->sizes + index);
+	pentry->is_archived = ent.DIR_Attr.ATTR_ARCHIVE;
+	pentry->is_readonly = ent.DIR_Attr.ATTR_READ_ONLY;
+	pentry->is_system = ent.DIR_Attr.ATTR_SYSTEM;
+	pentry->is_hidden = ent.DIR_Attr.ATTR_HIDDEN;
+	pentry->is_directory = ent.DIR_Attr.ATTR_DIRECTORY;
+	pentry->cluster_number = *(pcatalog->clusters + index);
+	pentry->created = decode_timestamp(ent.DIR_CrtDate, ent.DIR_CrtTime, ent.DIR_CrtTimeTenth);
+	pentry->modified = decode_timestamp(ent.DIR_WrtDate, ent.DIR_WrtTime, 0);
+	pentry->accessed = decode_timestamp(ent.DIR_LstAccDate, midnight, 0);
+	return 0;
+}
+int name_match(const char* glob, const char* name) {
+	if (glob == NULL || name == NULL) {
+		return 0;
+	}
+	// LAST STAR TO BACKTRACK TO
+	const char *star = NULL;
+	const char *retry = NULL;
+	while (*name != '\0') {
+		if (*glob == '*') {
+			star = glob++;
+			retry = name;
+		} else if (*glob == '?' || (*glob != '\0' && toupper((unsigned char)*glob) == toupper((unsigned char)*name))) {
+			glob++;
+			name++;
+		} else if (star != NULL) {
+			glob = star + 1;
+			name = ++retry;
+		} else {
+			return 0;
+		}
+	}
+	while (*glob == '*') {
+		glob++;
+	}
+	return *glob == '\0';
+}
+int64_t catalog_find(const struct catalog_t* pcatalog, const struct query_t* pquery, uint32_t* results, uint32_t capacity) {
+	if (pcatalog == NULL || pquery == NULL || (results == NULL && capacity > 0)) {
+		errno = EFAULT;
+		return -1;
+	}
+	uint32_t created_from = timestamp_key(pquery->created_from);
+	uint32_t created_to = timestamp_key(pquery->created_to);
+	uint32_t modified_from = timestamp_key(pquery->modified_from);
+	uint32_t modified_to = timestamp_key(pquery->modified_to);
+	uint32_t accessed_from = timestamp_key(pquery->accessed_from) & 0xFFFF0000;
+	uint32_t accessed_to = timestamp_key(pquery->accessed_to) & 0xFFFF0000;
+
+	// CHEAP COLUMNS FIRST, NAMES ONLY FOR WHAT IS LEFT
+	int64_t found = 0;
+	for (uint32_t i = 0; i < pcatalog->size; ++i) {
+		if ((pquery->flags & QUERY_SIZE) && (*(pcatalog->sizes + i) < pquery->min_size || *(pcatalog->sizes + i) > pquery->max_size)) {
+			continue;
+		}
+		uint8_t attributes = *(pcatalog->attributes + i);
+		if ((attributes & pquery->attr_set) != pquery->attr_set || (attributes & pquery->attr_clear) != 0) {
+			continue;
+		}
+		if ((pquery->flags & QUERY_CREATED) && (*(pcatalog->created + i) < created_from || *(pcatalog->created + i) > created_to)) {
+			continue;
+		}
+		if ((pquery->flags & QUERY_MODIFIED) && (*(pcatalog->modified + i) < modified_from || *(pcatalog->modified + i) > modified_to)) {
+			continue;
+		}
+		if ((pquery->flags & QUERY_ACCESSED) && (*(pcatalog->accessed + i) < accessed_from || *(pcatalog->accessed + i) > accessed_to)) {
+			continue;
+		}
+		if (pquery->name != NULL && !name_match(pquery->name, *(pcatalog->names + i))) {
+			continue;
+		}
+		if (found < capacity) {
+			*(results + found) = i;
+		}
+		found++;
+	}
+	return found;
+}
@@ -0,0 +1,69 @@
+#ifndef __CATALOG_H__
+#define __CATALOG_H__
+
+#include "file_reader.h"
+
+// ATTRIBUTE BITS
+#define ATTRIB_READ_ONLY    0x01
+#define ATTRIB_HIDDEN       0x02
+#define ATTRIB_SYSTEM       0x04
+#define ATTRIB_VOLUME_ID    0x08
+#define ATTRIB_DIRECTORY    0x10
+#define ATTRIB_ARCHIVE      0x20
+
+// QUERY FLAGS
+#define QUERY_SIZE          0x01
+#define QUERY_CREATED       0x02
+#define QUERY_MODIFIED      0x04
+#define QUERY_ACCESSED      0x08
+
+// ONE COLUMN PER FIELD, ROW IS AN ENTRY
+struct catalog_t {
+	struct volume_t*	pvolume;
+	uint32_t			size;
+	uint32_t			capacity;
+
+	char**				paths;
+	char				(*names)[13];
+	uint32_t*			sizes;
+	uint8_t*			attributes;
+	uint16_t*			clusters;
+
+	// SEE timestamp_key
+	uint32_t*			created;
+	uint32_t*			modified;
+	uint32_t*			accessed;
+	// 10 MS UNITS ON TOP OF created, 0-199
+	uint8_t*			created_tenth;
+};
+struct query_t {
+	// GLOB WITH * AND ?, NULL MATCHES ALL
+	const char*			name;
+	int 				flags;
+
+	uint32_t			min_size;
+	uint32_t			max_size;
+
+	// ATTRIBUTES THAT HAVE TO BE SET / CLEAR
+	uint8_t				attr_set;
+	uint8_t				attr_clear;
+
+	// INCLUSIVE RANGES
+	struct timestamp_t	created_from;
+	struct timestamp_t	created_to;
+	struct timestamp_t	modified_from;
+	struct timestamp_t	modified_to;
+	struct timestamp_t	accessed_from;
+	struct timestamp_t	accessed_to;
+};
+
+// CATALOG
+struct catalog_t* catalog_open(struct volume_t* pvolume);
+int catalog_close(struct catalog_t* pcatalog);
+int catalog_entry(const struct catalog_t* pcatalog, uint32_t index, struct dir_entry_t* pentry);
+
+// QUERIES
+int name_match(const char* glob, const char* name);
+int64_t catalog_find(const struct catalog_t* pcatalog, const struct query_t* pquery, uint32_t* results, uint32_t capacity);
+
+#endif
@@ -0,0 +1,176 @@
+#include "cluster_index.h"
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+static int index_entry(const struct walk_entry_t* pentry, void* arg) {
+	struct cluster_index_t *pindex = (struct cluster_index_t *)arg;
+	struct volume_t *pvolume = pindex->pvolume;
+	uint32_t CountofClusters = data_clusters(pvolume->bpb);
+	size_t FatSize = pvolume->bpb.BPB_BytsPerSec * pvolume->bpb.BPB_FATSz16;
+
+	uint16_t cluster = pentry->raw.DIR_FstClusLO;
+	// EMPTY FILES DO NOT OWN ANYTHING
+	if (cluster < 2 || (uint32_t)cluster - 2 >= CountofClusters) {
+		return 0;
+	}
+	// GROW ARRAY
+	if (pindex->size == pindex->capacity) {
+		uint32_t capacity = pindex->capacity ? pindex->capacity * 2 : 64;
+		if (capacity > OWNER_ID_MASK) {
+			capacity = OWNER_ID_MASK;
+		}
+		if (capacity == pindex->capacity) {
+			errno = EOVERFLOW;
+			return -1;
+		}
+		struct owner_entry_t *entries = realloc(pindex->entries, capacity * sizeof(struct owner_entry_t));
+		if (entries == NULL) {
+			errno = ENOMEM;
+			return -1;
+		}
+		pindex->entries = entries;
+		pindex->capacity = capacity;
+	}
+	struct owner_entry_t *owner = pindex->entries + pindex->size;
+	owner->path = malloc(strlen(pentry->path) + 1);
+	if (owner->path == NULL) {
+		errno = ENOMEM;
+		return -1;
+	}
+	strcpy(owner->path, pentry->path);
+	owner->size = pentry->raw.DIR_FileSize;
+	owner->is_directory = pentry->raw.DIR_Attr.ATTR_DIRECTORY;
+	owner->cluster_number = cluster;
+	uint16_t id = ++pindex->size;
+
+	// WALK CHAIN, LENGTH IS LIMITED SO CHAINS MERGED INTO A LOOP STOP
+	for (uint32_t pos = 0; pos < CountofClusters; ++pos) {
+		uint16_t *powner = pindex->owners + cluster;
+		// LOOP IN OWN CHAIN
+		if ((*powner & OWNER_ID_MASK) == id) {
+			break;
+		}
+		if (*powner == OWNER_NONE) {
+			*powner = id;
+			*(pindex->offsets + cluster) = pos;
+		} else if (!(*powner & OWNER_CROSSLINKED)) {
+			*powner |= OWNER_CROSSLINKED;
+			*(pindex->crosslinked + pindex->crosslinked_size++) = cluster;
+		}
+		uint16_t next = get_fat12_entry(pvolume->FAT1, FatSize, cluster);
+		// LAST CLUSTER OR BROKEN CHAIN
+		if (next < 2 || (uint32_t)next - 2 >= CountofClusters) {
+			break;
+		}
+		cluster = next;
+	}
+	return 0;
+}
+struct cluster_index_t* cluster_index_open(struct volume_t* pvolume) {
+	if (pvolume == NULL || pvolume->FAT1 == NULL) {
+		errno = EFAULT;
+		return NULL;
+	}
+	uint32_t Clusters = data_clusters(pvolume->bpb) + 2;
+	size_t FatSize = pvolume->bpb.BPB_BytsPerSec * pvolume->bpb.BPB_FATSz16;
+
+	struct cluster_index_t *pindex = calloc(1, sizeof(struct cluster_index_t));
+	if (pindex == NULL) {
+		errno = ENOMEM;
+		return NULL;
+	}
+	pindex->pvolume = pvolume;
+	pindex->owners = calloc(Clusters, sizeof(uint16_t));
+	pindex->offsets = calloc(Clusters, sizeof(uint16_t));
+	pindex->crosslinked = malloc(Clusters * sizeof(uint16_t));
+	pindex->orphaned = malloc(Clusters * sizeof(uint16_t));
+	if (pindex->owners == NULL || pindex->offsets == NULL || pindex->crosslinked == NULL || pindex->orphaned == NULL) {
+		cluster_index_close(pindex);
+		errno = ENOMEM;
+		return NULL;
+	}
+	// SINGLE PASS OVER DIR TREE
+	if (volume_walk(pvolume, 0, index_entry, pindex) != 0) {
+		cluster_index_close(pindex);
+		return NULL;
+	}
+	// ALLOCATED BUT NOT OWNED
+	for (uint16_t cluster = 2; cluster < Clusters; ++cluster) {
+		uint16_t value = get_fat12_entry(pvolume->FAT1, FatSize, cluster);
+		if (*(pindex->owners + cluster) == OWNER_NONE && value != 0x0000 && value != 0x0FF7) {
+			*(pindex->orphaned + pindex->orphaned_size++) = cluster;
+		}
+	}
+	return pindex;
+}
+int cluster_index_close(struct cluster_index_t* pindex) {
+	if (pindex == NULL) {
+		errno = EFAULT;
+		return -1;
+	}
+	for (uint16_t i = 0; i < pindex->size; ++i) {
+		free((pindex->entries + i)->path);
+	}
+	free(pindex->entries);
+	free(pindex->owners);
+	free(pindex->offsets);
+	free(pindex->crosslinked);
+	free(pindex->orphaned);
+	free(pindex);
+	return 0;
+}
+const struct owner_entry_t* cluster_owner(const struct cluster_index_t* pindex, uint16_t cluster, uint32_t* offset) {
+	if (pindex == NULL || pindex->owners == NULL) {
+		errno = EFAULT;
+		return NULL;
+	}
+	if (cluster < 2 || (uint32_t)cluster - 2 >= data_clusters(pindex->pvolume->bpb)) {
+		errno = ERANGE;
+		return NULL;
+	}
+	uint16_t id = *(pindex->owners + cluster) & OWNER_ID_MASK;
+	if (id == OWNER_NONE) {
+		errno = ENOENT;
+		return NULL;
+	}
+	if (offset != NULL) {
+		uint32_t ClusterSize = pindex->pvolume->bpb.BPB_SecPerClus * pindex->pvolume->bpb.BPB_BytsPerSec;
+		*offset = *(pindex->offsets + cluster) * ClusterSize;
+	}
+	return pindex->entries + id - 1;
+}
+const struct owner_entry_t* sector_owner(const struct cluster_index_t* pindex, uint32_t sector, uint32_t* offset) {
+	if (pindex == NULL || pindex->pvolume == NULL) {
+		errno = EFAULT;
+		return NULL;
+	}
+	struct bpb_t bpb = pindex->pvolume->bpb;
+	uint32_t FirstDataSector = data_addr(bpb) / bpb.BPB_BytsPerSec;
+	// SYSTEM AREA SECTORS ARE NOT OWNED BY FILES
+	if (sector < FirstDataSector) {
+		errno = ENOENT;
+		return NULL;
+	}
+	uint32_t cluster = (sector - FirstDataSector) / bpb.BPB_SecPerClus + 2;
+	if (cluster > 0xFFFF) {
+		errno = ERANGE;
+		return NULL;
+	}
+	const struct owner_entry_t *owner = cluster_owner(pindex, cluster, offset);
+	if (owner != NULL && offset != NULL) {
+		*offset += (sector - FirstDataSector) % bpb.BPB_SecPerClus * bpb.BPB_BytsPerSec;
+	}
+	return owner;
+}
+int cluster_is_crosslinked(const struct cluster_index_t* pindex, uint16_t cluster) {
+	if (pindex == NULL || pindex->owners == NULL) {
+		errno = EFAULT;
+		return -1;
+	}
+	if (cluster < 2 || (uint32_t)cluster - 2 >= data_clusters(pindex->pvolume->bpb)) {
+		errno = ERANGE;
+		return -1;
+	}
+	return (*(pindex->owners + cluster) & OWNER_CROSSLINKED) != 0;
+}
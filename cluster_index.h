@@ -0,0 +1,43 @@
+#ifndef __CLUSTER_INDEX_H__
+#define __CLUSTER_INDEX_H__
+
+#include "file_reader.h"
+
+// OWNER MAP VALUES
+#define OWNER_NONE          0x0000
+#define OWNER_CROSSLINKED   0x8000
+#define OWNER_ID_MASK       0x7FFF
+
+struct owner_entry_t {
+	char*				path;
+	uint32_t 			size;
+	int 				is_directory;
+	uint16_t			cluster_number;
+};
+struct cluster_index_t {
+	struct volume_t*		pvolume;
+
+	// PER CLUSTER: ENTRY ID + 1 AND ITS POSITION IN CHAIN
+	uint16_t*				owners;
+	uint16_t*				offsets;
+
+	struct owner_entry_t*	entries;
+	uint16_t				size;
+	uint16_t				capacity;
+
+	uint16_t*				crosslinked;
+	uint32_t				crosslinked_size;
+	uint16_t*				orphaned;
+	uint32_t				orphaned_size;
+};
+
+// CLUSTER INDEX
+struct cluster_index_t* cluster_index_open(struct volume_t* pvolume);
+int cluster_index_close(struct cluster_index_t* pindex);
+
+// LOOKUP
+const struct owner_entry_t* cluster_owner(const struct cluster_index_t* pindex, uint16_t cluster, uint32_t* offset);
+const struct owner_entry_t* sector_owner(const struct cluster_index_t* pindex, uint32_t sector, uint32_t* offset);
+int cluster_is_crosslinked(const struct cluster_index_t* pindex, uint16_t cluster);
+
+#endif
@@ -33,18 +33,22 @@ struct bpb_t {
 struct date_format_t {
 	union {
 		uint16_t date;
-		uint8_t  day   : 5;
-		uint8_t  month : 4;
-		uint8_t  year  : 7;
+		struct {
+			uint16_t day   : 5;
+			uint16_t month : 4;
+			uint16_t year  : 7;
+		} __attribute__((__packed__));
 	};
 } __attribute__((__packed__));
 
 struct time_format_t {
 	union {
 		uint16_t time;
-		uint8_t  second : 5;
-		uint8_t  minute : 6;
-		uint8_t  hour   : 5;
+		struct {
+			uint16_t second : 5;
+			uint16_t minute : 6;
+			uint16_t hour   : 5;
+		} __attribute__((__packed__));
 	};
 } __attribute__((__packed__));
 
@@ -0,0 +1,378 @@
+#include "file_hash.h"
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#ifdef __SSE4_2__
+#include <nmmintrin.h>
+#endif
+
+#define HASH_MAX_THREADS    64
+
+// CRC32C (CASTAGNOLI), SLICING BY 8 UNLESS SSE 4.2 IS AVAILABLE
+static uint32_t crc32c_table[8][256];
+static pthread_once_t crc32c_once = PTHREAD_ONCE_INIT;
+
+static void crc32c_init_table(void) {
+	for (uint32_t i = 0; i < 256; ++i) {
+		uint32_t crc = i;
+		for (int j = 0; j < 8; ++j) {
+			crc = crc & 1 ? (crc >> 1) ^ 0x82F63B78 : crc >> 1;
+		}
+		crc32c_table[0][i] = crc;
+	}
+	for (uint32_t i = 0; i < 256; ++i) {
+		for (int j = 1; j < 8; ++j) {
+			crc32c_table[j][i] = (crc32c_table[j - 1][i] >> 8) ^ crc32c_table[0][crc32c_table[j - 1][i] & 0xFF];
+		}
+	}
+}
+static void crc32c_init(void* context) {
+	pthread_once(&crc32c_once, crc32c_init_table);
+	*(uint32_t *)context = 0xFFFFFFFF;
+}
+static void crc32c_update(void* context, const void* data, size_t size) {
+	uint32_t crc = *(uint32_t *)context;
+	const uint8_t *p = (const uint8_t *)data;
+#ifdef __SSE4_2__
+	for (; size >= 8; size -= 8, p += 8) {
+		uint64_t word;
+		memcpy(&word, p, 8);
+		crc = (uint32_t)_mm_crc32_u64(crc, word);
+	}
+	for (; size > 0; --size, ++p) {
+		crc = _mm_crc32_u8(crc, *p);
+	}
+#else
+	for (; size >= 8; size -= 8, p += 8) {
+		uint32_t lo, hi;
+		memcpy(&lo, p, 4);
+		memcpy(&hi, p + 4, 4);
+		lo ^= crc;
+		crc = crc32c_table[7][lo & 0xFF] ^ crc32c_table[6][(lo >> 8) & 0xFF]
+			^ crc32c_table[5][(lo >> 16) & 0xFF] ^ crc32c_table[4][lo >> 24]
+			^ crc32c_table[3][hi & 0xFF] ^ crc32c_table[2][(hi >> 8) & 0xFF]
+			^ crc32c_table[1][(hi >> 16) & 0xFF] ^ crc32c_table[0][hi >> 24];
+	}
+	for (; size > 0; --size, ++p) {
+		crc = (crc >> 8) ^ crc32c_table[0][(crc ^ *p) & 0xFF];
+	}
+#endif
+	*(uint32_t *)context = crc;
+}
+static void crc32c_final(void* context, uint8_t* digest) {
+	uint32_t crc = ~*(uint32_t *)context;
+	for (int i = 0; i < 4; ++i) {
+		digest[i] = crc >> (24 - 8 * i);
+	}
+}
+const struct hash_algo_t hash_crc32c = {
+	"crc32c", sizeof(uint32_t), 4, crc32c_init, crc32c_update, crc32c_final
+};
+
+// XXH64 WITH SEED 0
+#define XXH_P1 0x9E3779B185EBCA87ULL
+#define XXH_P2 0xC2B2AE3D27D4EB4FULL
+#define XXH_P3 0x165667B19E3779F9ULL
+#define XXH_P4 0x85EBCA77C2B2AE63ULL
+#define XXH_P5 0x27D4EB2F165667C5ULL
+
+struct xxh64_state_t {
+	uint64_t			total;
+	uint64_t			v[4];
+	uint8_t				mem[32];
+	uint32_t			memsize;
+};
+
+static uint64_t xxh_rotl(uint64_t x, int r) {
+	return (x << r) | (x >> (64 - r));
+}
+static uint64_t xxh_read64(const uint8_t* p) {
+	uint64_t v;
+	memcpy(&v, p, 8);
+	return v;
+}
+static uint64_t xxh_round(uint64_t acc, uint64_t input) {
+	acc += input * XXH_P2;
+	acc = xxh_rotl(acc, 31);
+	return acc * XXH_P1;
+}
+static uint64_t xxh_merge(uint64_t acc, uint64_t val) {
+	acc ^= xxh_round(0, val);
+	return acc * XXH_P1 + XXH_P4;
+}
+static void xxh64_init(void* context) {
+	struct xxh64_state_t *state = (struct xxh64_state_t *)context;
+	memset(state, 0, sizeof(struct xxh64_state_t));
+	state->v[0] = XXH_P1 + XXH_P2;
+	state->v[1] = XXH_P2;
+	state->v[2] = 0;
+	state->v[3] = -XXH_P1;
+}
+static void xxh64_update(void* context, const void* data, size_t size) {
+	struct xxh64_state_t *state = (struct xxh64_state_t *)context;
+	const uint8_t *p = (const uint8_t *)data;
+	state->total += size;
+
+	// NOT ENOUGH FOR A STRIPE YET
+	if (state->memsize + size < 32) {
+		memcpy(state->mem + state->memsize, p, size);
+		state->memsize += size;
+		return;
+	}
+	// FINISH BUFFERED STRIPE
+	if (state->memsize > 0) {
+		uint32_t fill = 32 - state->memsize;
+		memcpy(state->mem + state->memsize, p, fill);
+		for (int i = 0; i < 4; ++i) {
+			state->v[i] = xxh_round(state->v[i], xxh_read64(state->mem + 8 * i));
+		}
+		p += fill;
+		size -= fill;
+		state->memsize = 0;
+	}
+	for (; size >= 32; size -= 32, p += 32) {
+		for (int i = 0; i < 4; ++i) {
+			state->v[i] = xxh_round(state->v[i], xxh_read64(p + 8 * i));
+		}
+	}
+	memcpy(state->mem, p, size);
+	state->memsize = size;
+}
+static void xxh64_final(void* context, uint8_t* digest) {
+	struct xxh64_state_t *state = (struct xxh64_state_t *)context;
+	uint64_t h;
+	if (state->total >= 32) {
+		h = xxh_rotl(state->v[0], 1) + xxh_rotl(state->v[1], 7) + xxh_rotl(state->v[2], 12) + xxh_rotl(state->v[3], 18);
+		for (int i = 0; i < 4; ++i) {
+			h = xxh_merge(h, state->v[i]);
+		}
+	} else {
+		h = XXH_P5;
+	}
+	h += state->total;
+
+	// TAIL
+	const uint8_t *p = state->mem;
+	uint32_t left = state->memsize;
+	for (; left >= 8; left -= 8, p += 8) {
+		h ^= xxh_round(0, xxh_read64(p));
+		h = xxh_rotl(h, 27) * XXH_P1 + XXH_P4;
+	}
+	if (left >= 4) {
+		uint32_t v;
+		memcpy(&v, p, 4);
+		h ^= (uint64_t)v * XXH_P1;
+		h = xxh_rotl(h, 23) * XXH_P2 + XXH_P3;
+		left -= 4;
+		p += 4;
+	}
+	for (; left > 0; --left, ++p) {
+		h ^= *p * XXH_P5;
+		h = xxh_rotl(h, 11) * XXH_P1;
+	}
+	// AVALANCHE
+	h ^= h >> 33;
+	h *= XXH_P2;
+	h ^= h >> 29;
+	h *= XXH_P3;
+	h ^= h >> 32;
+	for (int i = 0; i < 8; ++i) {
+		digest[i] = h >> (56 - 8 * i);
+	}
+}
+const struct hash_algo_t hash_xxh64 = {
+	"xxh64", sizeof(struct xxh64_state_t), 8, xxh64_init, xxh64_update, xxh64_final
+};
+
+struct hash_ctx_t {
+	struct volume_t*		pvolume;
+	struct manifest_t*		pmanifest;
+	_Atomic uint32_t		next;
+};
+
+static int collect_file(const struct walk_entry_t* pentry, void* arg) {
+	struct manifest_t *pmanifest = (struct manifest_t *)arg;
+	if (pentry->raw.DIR_Attr.ATTR_DIRECTORY) {
+		return 0;
+	}
+	// GROW ARRAY
+	if (pmanifest->size == pmanifest->capacity) {
+		uint32_t capacity = pmanifest->capacity ? pmanifest->capacity * 2 : 64;
+		struct manifest_entry_t *entries = realloc(pmanifest->entries, capacity * sizeof(struct manifest_entry_t));
+		if (entries == NULL) {
+			errno = ENOMEM;
+			return -1;
+		}
+		pmanifest->entries = entries;
+		pmanifest->capacity = capacity;
+	}
+	struct manifest_entry_t *ment = pmanifest->entries + pmanifest->size;
+	ment->path = malloc(strlen(pentry->path) + 1);
+	if (ment->path == NULL) {
+		errno = ENOMEM;
+		return -1;
+	}
+	strcpy(ment->path, pentry->path);
+	ment->size = pentry->raw.DIR_FileSize;
+	ment->cluster_number = pentry->raw.DIR_FstClusLO;
+	ment->error = 0;
+	memset(ment->digest, 0, HASH_MAX_DIGEST);
+	pmanifest->size++;
+	return 0;
+}
+// STREAM FILE EXTENTS THROUGH THE HASH, AT MOST ONE BUFFER AT A TIME
+static int hash_file(struct volume_t* pvolume, const struct hash_algo_t* algo, void* context, uint8_t* buffer, uint32_t buffer_clusters, uint16_t* stamps, uint16_t stamp, struct manifest_entry_t* ment) {
+	uint32_t ClusterSize = pvolume->bpb.BPB_SecPerClus * pvolume->bpb.BPB_BytsPerSec;
+	uint32_t CountofClusters = data_clusters(pvolume->bpb);
+	size_t FatSize = pvolume->bpb.BPB_BytsPerSec * pvolume->bpb.BPB_FATSz16;
+
+	algo->init(context);
+	uint32_t left = ment->size;
+	uint16_t cluster = ment->cluster_number;
+	while (left > 0) {
+		// CHAIN ENDED BEFORE SIZE BYTES
+		if (cluster < 2 || (uint32_t)cluster - 2 >= CountofClusters) {
+			return EIO;
+		}
+		// CLUSTER ALREADY HASHED, CHAIN LOOPS
+		if (*(stamps + cluster) == stamp) {
+			return ELOOP;
+		}
+		*(stamps + cluster) = stamp;
+		// EXTENT OF CONTIGUOUS CLUSTERS THAT FITS INTO BUFFER
+		uint16_t first = cluster;
+		uint32_t run = 1;
+		uint16_t next = get_fat12_entry(pvolume->FAT1, FatSize, cluster);
+		while (run < buffer_clusters && run * ClusterSize < left && next == cluster + 1 && (uint32_t)next - 2 < CountofClusters && *(stamps + next) != stamp) {
+			cluster = next;
+			*(stamps + cluster) = stamp;
+			next = get_fat12_entry(pvolume->FAT1, FatSize, cluster);
+			run++;
+		}
+		uint32_t bytes = run * ClusterSize < left ? run * ClusterSize : left;
+		// IMAGES IN MEMORY ARE HASHED IN PLACE
+		const void *view = disk_view(pvolume->pdisk, (data_addr(pvolume->bpb) + (first - 2) * ClusterSize) / BLOCK_SIZE, run * ClusterSize / BLOCK_SIZE);
+		if (view == NULL) {
+			if (cluster_read(pvolume, first, buffer, run) == -1) {
+				return errno;
+			}
+			view = buffer;
+		}
+		algo->update(context, view, bytes);
+		left -= bytes;
+		cluster = next;
+	}
+	algo->final(context, ment->digest);
+	return 0;
+}
+static void* hash_worker(void* arg) {
+	struct hash_ctx_t *ctx = (struct hash_ctx_t *)arg;
+	struct manifest_t *pmanifest = ctx->pmanifest;
+	uint32_t ClusterSize = ctx->pvolume->bpb.BPB_SecPerClus * ctx->pvolume->bpb.BPB_BytsPerSec;
+	uint32_t buffer_clusters = HASH_BUFFER_SIZE > ClusterSize ? HASH_BUFFER_SIZE / ClusterSize : 1;
+
+	uint32_t clusters = data_clusters(ctx->pvolume->bpb) + 2;
+
+	uint8_t *buffer = malloc(buffer_clusters * ClusterSize);
+	void *context = malloc(pmanifest->algo->context_size);
+	// CLUSTERS SEEN IN THE CURRENT FILE HOLD ITS STAMP
+	uint16_t *stamps = calloc(clusters, sizeof(uint16_t));
+	uint16_t stamp = 0;
+	while (1) {
+		uint32_t i = atomic_fetch_add(&ctx->next, 1);
+		if (i >= pmanifest->size) {
+			break;
+		}
+		struct manifest_entry_t *ment = pmanifest->entries + i;
+		if (buffer == NULL || context == NULL || stamps == NULL) {
+			ment->error = ENOMEM;
+			continue;
+		}
+		if (++stamp == 0) {
+			memset(stamps, 0, clusters * sizeof(uint16_t));
+			stamp = 1;
+		}
+		ment->error = hash_file(ctx->pvolume, pmanifest->algo, context, buffer, buffer_clusters, stamps, stamp, ment);
+	}
+	free(stamps);
+	free(context);
+	free(buffer);
+	return NULL;
+}
+struct manifest_t* volume_hash(struct volume_t* pvolume, const struct hash_algo_t* algo, int threads) {
+	if (pvolume == NULL || pvolume->FAT1 == NULL || algo == NULL) {
+		errno = EFAULT;
+		return NULL;
+	}
+	if (algo->digest_size > HASH_MAX_DIGEST || algo->init == NULL || algo->update == NULL || algo->final == NULL) {
+		errno = EINVAL;
+		return NULL;
+	}
+	if (threads < 1) {
+		long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+		threads = cpus > 0 ? (int)cpus : 1;
+	}
+	if (threads > HASH_MAX_THREADS) {
+		threads = HASH_MAX_THREADS;
+	}
+	struct manifest_t *pmanifest = calloc(1, sizeof(struct manifest_t));
+	if (pmanifest == NULL) {
+		errno = ENOMEM;
+		return NULL;
+	}
+	pmanifest->algo = algo;
+	// LIST ALL FILES FIRST
+	if (volume_walk(pvolume, 0, collect_file, pmanifest) != 0) {
+		manifest_free(pmanifest);
+		return NULL;
+	}
+	struct hash_ctx_t ctx;
+	ctx.pvolume = pvolume;
+	ctx.pmanifest = pmanifest;
+	atomic_init(&ctx.next, 0);
+
+	// CALLING THREAD WORKS TOO
+	pthread_t workers[HASH_MAX_THREADS];
+	int started = 1;
+	for (; started < threads && (uint32_t)started < pmanifest->size; ++started) {
+		if (pthread_create(workers + started, NULL, hash_worker, &ctx) != 0) {
+			break;
+		}
+	}
+	hash_worker(&ctx);
+	for (int i = 1; i < started; ++i) {
+		pthread_join(workers[i], NULL);
+	}
+	return pmanifest;
+}
+int manifest_free(struct manifest_t* pmanifest) {
+	if (pmanifest == NULL) {
+		errno = EFAULT;
+		return -1;
+	}
+	for (uint32_t i = 0; i < pmanifest->size; ++i) {
+		free((pmanifest->entries + i)->path);
+	}
+	free(pmanifest->entries);
+	free(pmanifest);
+	return 0;
+}
+void print_manifest(const struct manifest_t* pmanifest) {
+	if (pmanifest == NULL || pmanifest->algo == NULL) {
+		return;
+	}
+	for (uint32_t i = 0; i < pmanifest->size; ++i) {
+		const struct manifest_entry_t *ment = pmanifest->entries + i;
+		if (ment->error != 0) {
+			printf("%-*s  %10u  %s\n", (int)pmanifest->algo->digest_size * 2, "error", ment->size, ment->path);
+			continue;
+		}
+		for (size_t j = 0; j < pmanifest->algo->digest_size; ++j) {
+			printf("%02x", ment->digest[j]);
+		}
+		printf("  %10u  %s\n", ment->size, ment->path);
+	}
+}
@@ -0,0 +1,44 @@
+#ifndef __FILE_HASH_H__
+#define __FILE_HASH_H__
+
+#include "file_reader.h"
+
+#define HASH_MAX_DIGEST     64
+#define HASH_BUFFER_SIZE    (64 * 1024)
+
+struct hash_algo_t {
+	const char*			name;
+	size_t				context_size;
+	size_t				digest_size;
+
+	void				(*init)(void* context);
+	void				(*update)(void* context, const void* data, size_t size);
+	void				(*final)(void* context, uint8_t* digest);
+};
+struct manifest_entry_t {
+	char*				path;
+	uint32_t 			size;
+	uint16_t			cluster_number;
+
+	uint8_t				digest[HASH_MAX_DIGEST];
+	int 				error;
+};
+struct manifest_t {
+	const struct hash_algo_t*	algo;
+	struct manifest_entry_t*	entries;
+	uint32_t					size;
+	uint32_t					capacity;
+};
+
+// BUILT IN ALGORITHMS
+extern const struct hash_algo_t hash_crc32c;
+extern const struct hash_algo_t hash_xxh64;
+
+// HASHING
+struct manifest_t* volume_hash(struct volume_t* pvolume, const struct hash_algo_t* algo, int threads);
+int manifest_free(struct manifest_t* pmanifest);
+
+// PRINTING
+void print_manifest(const struct manifest_t* pmanifest);
+
+#endif
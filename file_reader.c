@@ -4,6 +4,7 @@
 #include <strings.h>
 #include <string.h>
 #include <ctype.h>
+#include <unistd.h>
 
 uint32_t fat1_addr(struct bpb_t bpb) {
 	return bpb.BPB_RsvdSecCnt * bpb.BPB_BytsPerSec;
@@ -20,6 +21,12 @@ uint32_t root_addr(struct bpb_t bpb) {
 uint32_t data_addr(struct bpb_t bpb) {
 	return root_addr(bpb) + bpb.BPB_RootEntCnt * FAT_RECORD_SIZE;
 }
+uint32_t data_clusters(struct bpb_t bpb) {
+	uint32_t RootDirSectors = ((bpb.BPB_RootEntCnt * FAT_RECORD_SIZE) + (bpb.BPB_BytsPerSec - 1)) / bpb.BPB_BytsPerSec;
+	uint32_t TotalSec = (bpb.BPB_TotSec16 != 0) ? bpb.BPB_TotSec16 : bpb.BPB_TotSec32;
+	uint32_t DataSec = TotalSec - (bpb.BPB_RsvdSecCnt + (bpb.BPB_NumFATs * bpb.BPB_FATSz16) + RootDirSectors);
+	return DataSec / bpb.BPB_SecPerClus;
+}
 
 struct disk_t* disk_open_from_file(const char* volume_file_name) {
 	if (volume_file_name == NULL) {
@@ -32,6 +39,8 @@ struct disk_t* disk_open_from_file(const char* volume_file_name) {
 		return NULL;
 	}
 	pdisk->filename = volume_file_name;
+	pdisk->memory = NULL;
+	pdisk->length = 0;
 	pdisk->handle = fopen(volume_file_name, "rb");
 	if (pdisk->handle == NULL) {
 		free(pdisk);
@@ -40,39 +49,81 @@ struct disk_t* disk_open_from_file(const char* volume_file_name) {
 	}
 	return pdisk;
 }
-int disk_read(struct disk_t* pdisk, int32_t first_sector, void* buffer, int32_t sectors_to_read) {
-	if (pdisk == NULL || pdisk->filename == NULL || pdisk->handle == NULL) {
+struct disk_t* disk_open_from_memory(const void* buffer, size_t length) {
+	if (buffer == NULL) {
 		errno = EFAULT;
-		return -1;
+		return NULL;
 	}
-	fseek(pdisk->handle, first_sector*BLOCK_SIZE, SEEK_SET);
-	if (fread(buffer, BLOCK_SIZE, sectors_to_read, pdisk->handle) != (size_t)sectors_to_read) {
-		errno = ERANGE;
-		return -1;
+	struct disk_t *pdisk = malloc(sizeof(struct disk_t));
+	if (pdisk == NULL) {
+		errno = ENOMEM;
+		return NULL;
 	}
-	return sectors_to_read;
+	// BUFFER IS NOT COPIED, IT HAS TO OUTLIVE THE DISK
+	pdisk->filename = NULL;
+	pdisk->handle = NULL;
+	pdisk->memory = buffer;
+	pdisk->length = length;
+	return pdisk;
 }
-int disk_close(struct disk_t* pdisk) {
-	if (pdisk == NULL || pdisk->filename == NULL || pdisk->handle == NULL) {
+int disk_read(struct disk_t* pdisk, int32_t first_sector, void* buffer, int32_t sectors_to_read) {
+	if (pdisk == NULL || (pdisk->handle == NULL && pdisk->memory == NULL)) {
 		errno = EFAULT;
 		return -1;
 	}
-	fclose(pdisk->handle);
-	free(pdisk);
-	return 0;
+	if (pdisk->memory != NULL) {
+		const void *view = disk_view(pdisk, first_sector, sectors_to_read);
+		if (view == NULL) {
+			return -1;
+		}
+		memcpy(buffer, view, (size_t)sectors_to_read * BLOCK_SIZE);
+		return sectors_to_read;
+	}
+	// POSITIONAL READ, DISK CAN BE SHARED BETWEEN THREADS
+	size_t length = (size_t)sectors_to_read * BLOCK_SIZE;
+	off_t offset = (off_t)first_sector * BLOCK_SIZE;
+	size_t got = 0;
+	while (got < length) {
+		ssize_t ret = pread(fileno(pdisk->handle), (uint8_t *)buffer + got, length - got, offset + got);
+		if (ret <= 0) {
+			errno = ERANGE;
+			return -1;
+		}
+		got += ret;
+	}
+	return sectors_to_read;
 }
-struct volume_t* fat_open(struct disk_t* pdisk, uint32_t first_sector) {
-	if (pdisk == NULL || pdisk->filename == NULL || pdisk->handle == NULL) {
+const void* disk_view(struct disk_t* pdisk, int32_t first_sector, int32_t sectors_to_view) {
+	if (pdisk == NULL || (pdisk->handle == NULL && pdisk->memory == NULL)) {
 		errno = EFAULT;
 		return NULL;
 	}
-	struct bpb_t bpb;
-	if (disk_read(pdisk, first_sector, &bpb, 1) != 1) {
+	// ONLY IMAGES IN MEMORY CAN BE VIEWED
+	if (pdisk->memory == NULL) {
+		errno = ENOTSUP;
+		return NULL;
+	}
+	if (first_sector < 0 || sectors_to_view < 0 || ((size_t)first_sector + sectors_to_view) * BLOCK_SIZE > pdisk->length) {
 		errno = ERANGE;
 		return NULL;
 	}
+	return pdisk->memory + (size_t)first_sector * BLOCK_SIZE;
+}
+int disk_close(struct disk_t* pdisk) {
+	if (pdisk == NULL || (pdisk->handle == NULL && pdisk->memory == NULL)) {
+		errno = EFAULT;
+		return -1;
+	}
+	if (pdisk->handle != NULL) {
+		fclose(pdisk->handle);
+	}
+	free(pdisk);
+	return 0;
+}
+int fat_check_bpb(struct bpb_t bpb) {
 	if (   bpb.BS_Signature != SIG
 		|| bpb.BPB_BytsPerSec != BLOCK_SIZE
+		|| bpb.BPB_SecPerClus == 0
 		|| (bpb.BPB_SecPerClus & (bpb.BPB_SecPerClus - 1)) != 0
 		|| bpb.BPB_RsvdSecCnt < 1
 		|| bpb.BPB_NumFATs < 1
@@ -83,19 +134,27 @@ struct volume_t* fat_open(struct disk_t* pdisk, uint32_t first_sector) {
 		|| bpb.BPB_FATSz16 < 1
 		|| bpb.BPB_FATSz16 > 12) {
 		errno = EINVAL;
-		return NULL;
+		return -1;
 	}
 
-	// CALC
-	uint32_t RootDirSectors = ((bpb.BPB_RootEntCnt * FAT_RECORD_SIZE) + (bpb.BPB_BytsPerSec - 1)) / bpb.BPB_BytsPerSec;
-	uint32_t FirstDataSector = bpb.BPB_RsvdSecCnt + (bpb.BPB_NumFATs * bpb.BPB_FATSz16) + RootDirSectors;
-	uint32_t TotalSec = (bpb.BPB_TotSec16 != 0) ? bpb.BPB_TotSec16 : bpb.BPB_TotSec32;
-	uint32_t DataSec = TotalSec - FirstDataSector;
-	uint32_t CountofClusters = DataSec / bpb.BPB_SecPerClus;
-
 	// CHECK FOR FAT12
-	if (CountofClusters >= 4085) {
+	if (data_clusters(bpb) >= 4085) {
 		errno = EINVAL;
+		return -1;
+	}
+	return 0;
+}
+struct volume_t* fat_open(struct disk_t* pdisk, uint32_t first_sector) {
+	if (pdisk == NULL || (pdisk->handle == NULL && pdisk->memory == NULL)) {
+		errno = EFAULT;
+		return NULL;
+	}
+	struct bpb_t bpb;
+	if (disk_read(pdisk, first_sector, &bpb, 1) != 1) {
+		errno = ERANGE;
+		return NULL;
+	}
+	if (fat_check_bpb(bpb) != 0) {
 		return NULL;
 	}
 
@@ -127,14 +186,8 @@ struct volume_t* fat_open(struct disk_t* pdisk, uint32_t first_sector) {
 			free(pvolume);
 			return NULL;
 		}
+		// COPIES MAY DIFFER, FAT 1 IS USED AND volume_check REPORTS THE DIFFERENCE
 		disk_read(pdisk, fat2_addr(bpb) / BLOCK_SIZE, pvolume->FAT2, bpb.BPB_FATSz16);
-		if (memcmp(pvolume->FAT1, pvolume->FAT2, bpb.BPB_FATSz16) != 0) {
-			free(pvolume->FAT1);
-			free(pvolume->FAT2);
-			free(pvolume);
-			errno = EINVAL;
-			return NULL;
-		}
 	}
 	// RETURN
 	return pvolume;
@@ -151,23 +204,53 @@ int fat_close(struct volume_t* pvolume) {
 	free(pvolume);
 	return 0;
 }
+uint16_t get_fat12_entry(const void * const buffer, size_t size, uint16_t cluster) {
+	uint32_t bytes = (cluster / 2) * 3;
+	// OUT OF FAT IS TREATED AS A BAD CLUSTER
+	if (buffer == NULL || bytes + 2 >= size) {
+		return 0x0FF7;
+	}
+	uint8_t l = *((uint8_t *)buffer + bytes);
+	uint8_t m = *((uint8_t *)buffer + bytes + 1);
+	uint8_t h = *((uint8_t *)buffer + bytes + 2);
+	return cluster % 2 != 0 ? (h << 4) | (m >> 4) : ((m & 0xF) << 8) | l;
+}
+int set_fat12_entry(void * const buffer, size_t size, uint16_t cluster, uint16_t value) {
+	uint32_t bytes = (cluster / 2) * 3;
+	if (buffer == NULL || bytes + 2 >= size || value > 0x0FFF) {
+		errno = EINVAL;
+		return -1;
+	}
+	uint8_t *p = (uint8_t *)buffer + bytes;
+	if (cluster % 2 != 0) {
+		*(p + 1) = (*(p + 1) & 0x0F) | ((value & 0xF) << 4);
+		*(p + 2) = value >> 4;
+	} else {
+		*p = value & 0xFF;
+		*(p + 1) = (*(p + 1) & 0xF0) | (value >> 8);
+	}
+	return 0;
+}
 struct clusters_chain_t *get_chain_fat12(const void * const buffer, size_t size, uint16_t first_cluster) {
 	if (buffer == NULL || size < 3 || first_cluster < 1) {
+		errno = EINVAL;
 		return NULL;
 	}
 	uint16_t pos = first_cluster;
 	int len = 0;
 	while(1) {
-		// CALC VALUES
-		uint16_t bytes = pos % 2 == 0 ? (pos/2) * 3 : ((pos - 1)/2) * 3;
-		uint8_t l = *((uint8_t *)buffer + bytes);
-		uint8_t m = *((uint8_t *)buffer + bytes + 1);
-		uint8_t h = *((uint8_t *)buffer + bytes + 2);
-		uint16_t param = pos % 2 != 0 ? (h << 4) | (m >> 4) : ((m & 0xF) << 8) | l;
+		uint16_t param = get_fat12_entry(buffer, size, pos);
 		len++;
 
+		// LONGER THAN FAT ITSELF, CHAIN LOOPS
+		if ((size_t)len > size * 2 / 3) {
+			errno = ELOOP;
+			return NULL;
+		}
+
 		// BAD CLUSTER
 		if (param == 0x0FF7) {
+			errno = EIO;
 			return NULL;
 		}
 		// LAST CLUSTER IN CHAIN OR UNUSED OR RESERVED CLUSTER
@@ -182,22 +265,19 @@ struct clusters_chain_t *get_chain_fat12(const void * const buffer, size_t size,
 	// ALLOC STRUCT
 	struct clusters_chain_t *ret = malloc(sizeof(struct clusters_chain_t));
 	if (ret == NULL) {
+		errno = ENOMEM;
 		return NULL;
 	}
 	// ALLOC ARRAY
 	ret->clusters = malloc(sizeof(uint16_t)*len);
 	if (ret->clusters == NULL) {
 		free(ret);
+		errno = ENOMEM;
 		return NULL;
 	}
 	pos = first_cluster;
 	for (int i = 0; i < len; ++i) {
-		// CALC VALUES
-		uint16_t bytes = pos % 2 == 0 ? (pos/2) * 3 : ((pos - 1)/2) * 3;
-		uint8_t l = *((uint8_t *)buffer + bytes);
-		uint8_t m = *((uint8_t *)buffer + bytes + 1);
-		uint8_t h = *((uint8_t *)buffer + bytes + 2);
-		uint16_t param = pos % 2 != 0 ? (h << 4) | (m >> 4) : ((m & 0xF) << 8) | l;
+		uint16_t param = get_fat12_entry(buffer, size, pos);
 
 		// SAVE POS TO ARRAY
 		*(ret->clusters + i) = pos;
@@ -211,6 +291,44 @@ struct clusters_chain_t *get_chain_fat12(const void * const buffer, size_t size,
 	ret->size = len;
 	return ret;
 }
+int cluster_read(struct volume_t* pvolume, uint16_t first_cluster, void* buffer, uint32_t clusters_to_read) {
+	if (pvolume == NULL || pvolume->pdisk == NULL || buffer == NULL) {
+		errno = EFAULT;
+		return -1;
+	}
+	// ONLY DATA CLUSTERS CAN BE READ
+	if (first_cluster < 2 || first_cluster - 2 + clusters_to_read > data_clusters(pvolume->bpb)) {
+		errno = ERANGE;
+		return -1;
+	}
+	uint32_t ClusterSize = pvolume->bpb.BPB_SecPerClus * pvolume->bpb.BPB_BytsPerSec;
+	uint32_t address = data_addr(pvolume->bpb) + (first_cluster - 2) * ClusterSize;
+	if (disk_read(pvolume->pdisk, address / BLOCK_SIZE, buffer, clusters_to_read * ClusterSize / BLOCK_SIZE) == -1) {
+		errno = ENXIO;
+		return -1;
+	}
+	return clusters_to_read;
+}
+int chain_read(struct volume_t* pvolume, const struct clusters_chain_t* chain, void* buffer) {
+	if (pvolume == NULL || chain == NULL || chain->clusters == NULL || buffer == NULL) {
+		errno = EFAULT;
+		return -1;
+	}
+	uint32_t ClusterSize = pvolume->bpb.BPB_SecPerClus * pvolume->bpb.BPB_BytsPerSec;
+	uint32_t i = 0;
+	while (i < chain->size) {
+		// MERGE CONTIGUOUS CLUSTERS INTO ONE READ
+		uint32_t run = 1;
+		while (i + run < chain->size && *(chain->clusters + i + run) == *(chain->clusters + i) + run) {
+			run++;
+		}
+		if (cluster_read(pvolume, *(chain->clusters + i), (uint8_t *)buffer + i * ClusterSize, run) == -1) {
+			return -1;
+		}
+		i += run;
+	}
+	return chain->size;
+}
 struct file_t* file_open(struct volume_t* pvolume, const char* file_name) {
 	if (file_name == NULL || pvolume == NULL || pvolume->pdisk == NULL || pvolume->bpb.BPB_NumFATs < 1 || pvolume->FAT1 == NULL) {
 		errno = EFAULT;
@@ -325,15 +443,13 @@ struct file_t* file_open(struct volume_t* pvolume, const char* file_name) {
 
 		
 		// MAP CLUSTERS WITH CHAINS ONTO ALLOCATED MEM
-		for (uint32_t i = 0; i < chain->size; ++i) {
-			if (disk_read(pvolume->pdisk, (data_addr(pvolume->bpb) + (*(chain->clusters + i) - 2) * BytesPerCluster) / BLOCK_SIZE, pFile->file + i * BytesPerCluster, BytesPerCluster / BLOCK_SIZE) == -1) {
-				free(chain->clusters);
-				free(chain);
-				free(pFile->file);
-				free(pFile);
-				free(full_path);
-				return NULL;
-			}
+		if (chain_read(pvolume, chain, pFile->file) == -1) {
+			free(chain->clusters);
+			free(chain);
+			free(pFile->file);
+			free(pFile);
+			free(full_path);
+			return NULL;
 		}
 		free(chain->clusters);
 		free(chain);
@@ -435,6 +551,21 @@ void convert_entry_name(struct actual_dir_entry_t ent, char *dest) {
 	}
 	*(dest + n_len + (e_len ? e_len + 1 : 0)) = '\0';
 }
+static void fill_entry(const struct actual_dir_entry_t* ent, struct dir_entry_t* pentry) {
+	convert_entry_name(*ent, pentry->name);
+	pentry->size = ent->DIR_FileSize;
+	pentry->is_archived = ent->DIR_Attr.ATTR_ARCHIVE;
+	pentry->is_readonly = ent->DIR_Attr.ATTR_READ_ONLY;
+	pentry->is_system = ent->DIR_Attr.ATTR_SYSTEM;
+	pentry->is_hidden = ent->DIR_Attr.ATTR_HIDDEN;
+	pentry->is_directory = ent->DIR_Attr.ATTR_DIRECTORY;
+	pentry->cluster_number = ent->DIR_FstClusLO;
+	pentry->created = decode_timestamp(ent->DIR_CrtDate, ent->DIR_CrtTime, ent->DIR_CrtTimeTenth);
+	pentry->modified = decode_timestamp(ent->DIR_WrtDate, ent->DIR_WrtTime, 0);
+	// ONLY DATE OF LAST ACCESS IS KEPT
+	struct time_format_t midnight = { .time = 0 };
+	pentry->accessed = decode_timestamp(ent->DIR_LstAccDate, midnight, 0);
+}
 struct dir_t* dir_open(struct volume_t* pvolume, const char* dir_path) {
 	if (pvolume == NULL || dir_path == NULL) {
 		errno = EFAULT;
@@ -511,66 +642,132 @@ int dir_close(struct dir_t* pdir) {
 	free(pdir);
 	return 0;
 }
-int dir_read(struct dir_t* pdir, struct dir_entry_t* pentry) {
-	if (pdir == NULL || pentry == NULL) {
+void* dir_load(struct volume_t* pvolume, uint16_t cluster_number, uint32_t* entries) {
+	if (pvolume == NULL || entries == NULL) {
 		errno = EFAULT;
-		return -1;
+		return NULL;
 	}
 	uint8_t *buffer = NULL;
-	// SEARCH ROOT DIR
-	if (pdir->cluster_number == 0) {
-		buffer = malloc(pdir->pvolume->bpb.BPB_RootEntCnt*FAT_RECORD_SIZE);
+	// LOAD ROOT DIR
+	if (cluster_number == 0) {
+		buffer = malloc(pvolume->bpb.BPB_RootEntCnt*FAT_RECORD_SIZE);
 		if (buffer == NULL) {
 			errno = ENOMEM;
-			return -1;
+			return NULL;
 		}
 		// READ TO BUFFER
-		if (disk_read(pdir->pvolume->pdisk, root_addr(pdir->pvolume->bpb) / BLOCK_SIZE, buffer, pdir->pvolume->bpb.BPB_RootEntCnt*FAT_RECORD_SIZE / BLOCK_SIZE) == -1) {
+		if (disk_read(pvolume->pdisk, root_addr(pvolume->bpb) / BLOCK_SIZE, buffer, pvolume->bpb.BPB_RootEntCnt*FAT_RECORD_SIZE / BLOCK_SIZE) == -1) {
 			errno = ENXIO;
 			free(buffer);
-			return -1;
+			return NULL;
 		}
+		*entries = pvolume->bpb.BPB_RootEntCnt;
+		return buffer;
 	}
-	else {
-		struct clusters_chain_t *chain = get_chain_fat12(pdir->pvolume->FAT1, pdir->pvolume->bpb.BPB_BytsPerSec * pdir->pvolume->bpb.BPB_FATSz16, pdir->cluster_number);
-		if (chain == NULL) {
+	// ERRNO COMES FROM CHAIN, E.G. ELOOP
+	struct clusters_chain_t *chain = get_chain_fat12(pvolume->FAT1, pvolume->bpb.BPB_BytsPerSec * pvolume->bpb.BPB_FATSz16, cluster_number);
+	if (chain == NULL) {
+		return NULL;
+	}
+	uint32_t ClusterSize = pvolume->bpb.BPB_SecPerClus * pvolume->bpb.BPB_BytsPerSec;
+	// CLUSTER AWARE BUFFER
+	buffer = malloc(chain->size*ClusterSize);
+	if (buffer == NULL) {
+		free(chain->clusters);
+		free(chain);
+		errno = ENOMEM;
+		return NULL;
+	}
+	// READ ALL DIR CLUSTERS
+	if (chain_read(pvolume, chain, buffer) == -1) {
+		errno = ENXIO;
+		free(chain->clusters);
+		free(chain);
+		free(buffer);
+		return NULL;
+	}
+	*entries = chain->size * ClusterSize / FAT_RECORD_SIZE;
+	free(chain->clusters);
+	free(chain);
+	return buffer;
+}
+void* deleted_dir_load(struct volume_t* pvolume, uint16_t cluster_number, uint32_t* entries) {
+	if (pvolume == NULL || pvolume->FAT1 == NULL || entries == NULL) {
+		errno = EFAULT;
+		return NULL;
+	}
+	uint32_t ClusterSize = pvolume->bpb.BPB_SecPerClus * pvolume->bpb.BPB_BytsPerSec;
+	uint32_t CountofClusters = data_clusters(pvolume->bpb);
+	size_t FatSize = pvolume->bpb.BPB_BytsPerSec * pvolume->bpb.BPB_FATSz16;
+	uint32_t PerCluster = ClusterSize / FAT_RECORD_SIZE;
+
+	if (cluster_number < 2 || (uint32_t)cluster_number - 2 >= CountofClusters) {
+		errno = ERANGE;
+		return NULL;
+	}
+	// FIRST CLUSTER WAS REUSED
+	if (get_fat12_entry(pvolume->FAT1, FatSize, cluster_number) != 0x0000) {
+		errno = EBUSY;
+		return NULL;
+	}
+	// CHAIN IS GONE, ASSUME CONTIGUOUS FREE CLUSTERS UP TO THE END OF DIR MARK
+	uint8_t *buffer = NULL;
+	uint32_t clusters = 0;
+	uint16_t cluster = cluster_number;
+	while (1) {
+		uint8_t *new_buffer = realloc(buffer, (clusters + 1) * ClusterSize);
+		if (new_buffer == NULL) {
+			free(buffer);
 			errno = ENOMEM;
-			return -1;
+			return NULL;
 		}
-		uint32_t ClusterSize = pdir->pvolume->bpb.BPB_SecPerClus * pdir->pvolume->bpb.BPB_BytsPerSec;
-		// CLUSTER AWARE BUFFER
-		buffer = malloc(chain->size*ClusterSize);
-		if (buffer == NULL) {
-			free(chain->clusters);
-			free(chain);
-			errno = ENOMEM;
-			return -1;
+		buffer = new_buffer;
+		struct actual_dir_entry_t *dir = (struct actual_dir_entry_t *)(buffer + clusters * ClusterSize);
+		if (cluster_read(pvolume, cluster, dir, 1) == -1) {
+			free(buffer);
+			return NULL;
 		}
-		// READ ALL DIR CLUSTERS
-		for (size_t i = 0; i < chain->size; ++i) {
-			uint32_t address = data_addr(pdir->pvolume->bpb) + (*(chain->clusters + i) - 2) * ClusterSize;
-			// READ TO BUFFER
-			if (disk_read(pdir->pvolume->pdisk, address / BLOCK_SIZE, buffer + i*ClusterSize, ClusterSize / BLOCK_SIZE) == -1) {
-				errno = ENXIO;
-				free(chain->clusters);
-				free(chain);
-				free(buffer);
-				return -1;
-			}
+		// OLD DATA OF A FILE IS NOT A DIR, IT STARTS WITH . AND ..
+		if (clusters == 0 && (PerCluster < 2
+			|| memcmp(dir->DIR_Name, ".          ", 11) != 0 || !dir->DIR_Attr.ATTR_DIRECTORY || dir->DIR_FstClusLO != cluster_number
+			|| memcmp((dir + 1)->DIR_Name, "..         ", 11) != 0 || !(dir + 1)->DIR_Attr.ATTR_DIRECTORY)) {
+			free(buffer);
+			errno = ENOTDIR;
+			return NULL;
+		}
+		clusters++;
+		int ended = 0;
+		for (uint32_t i = 0; i < PerCluster && !ended; ++i) {
+			ended = (dir + i)->DIR_Name[0] == 0x00;
+		}
+		cluster++;
+		if (ended || (uint32_t)cluster - 2 >= CountofClusters || get_fat12_entry(pvolume->FAT1, FatSize, cluster) != 0x0000) {
+			break;
 		}
-		free(chain->clusters);
-		free(chain);
+	}
+	*entries = clusters * PerCluster;
+	return buffer;
+}
+int dir_read(struct dir_t* pdir, struct dir_entry_t* pentry) {
+	if (pdir == NULL || pentry == NULL) {
+		errno = EFAULT;
+		return -1;
+	}
+	uint32_t entries = 0;
+	uint8_t *buffer = dir_load(pdir->pvolume, pdir->cluster_number, &entries);
+	if (buffer == NULL) {
+		return -1;
 	}
 	// GO OVER WHOLE DIR
 	struct actual_dir_entry_t *ent;
 	while(1) {
-		ent = (struct actual_dir_entry_t *)(buffer + pdir->curr_i * FAT_RECORD_SIZE);
-		// ENTRY CORRUPTION
-		if (ent == NULL) {
-			errno = EFAULT;
+		// END OF BUFFER
+		if (pdir->curr_i >= entries) {
+			errno = EIO;
 			free(buffer);
 			return 1;
 		}
+		ent = (struct actual_dir_entry_t *)(buffer + pdir->curr_i * FAT_RECORD_SIZE);
 		pdir->curr_i++;
 		// END OF DIR
 		if (ent->DIR_Name[0] == 0x00) {
@@ -590,17 +787,200 @@ int dir_read(struct dir_t* pdir, struct dir_entry_t* pentry) {
 			break;
 		}
 	}	
-	convert_entry_name(*ent, pentry->name);
-	pentry->size = ent->DIR_FileSize;
-	pentry->is_archived = ent->DIR_Attr.ATTR_ARCHIVE;
-	pentry->is_readonly = ent->DIR_Attr.ATTR_READ_ONLY;
-	pentry->is_system = ent->DIR_Attr.ATTR_SYSTEM;
-	pentry->is_hidden = ent->DIR_Attr.ATTR_HIDDEN;
-	pentry->is_directory = ent->DIR_Attr.ATTR_DIRECTORY;
-	pentry->cluster_number = ent->DIR_FstClusLO;
+	fill_entry(ent, pentry);
 	free(buffer);
 	return 0;
 }
+int file_stat(struct volume_t* pvolume, const char* file_name, struct dir_entry_t* pentry) {
+	if (pvolume == NULL || file_name == NULL || pentry == NULL) {
+		errno = EFAULT;
+		return -1;
+	}
+	char *curr_path = malloc(strlen(file_name) + 1);
+	if (curr_path == NULL) {
+		errno = ENOMEM;
+		return -1;
+	}
+	*(curr_path + strlen(file_name)) = '\0';
+	for (int i = 0; *(file_name + i) != '\0'; ++i) {
+		*(curr_path + i) = toupper(*(file_name + i));
+	}
+	// ROOT DIR HAS NO ENTRY OF ITS OWN
+	memset(pentry, 0, sizeof(struct dir_entry_t));
+	strcpy(pentry->name, "\\");
+	pentry->is_directory = 1;
+
+	// EVERY DIR ON THE WAY IS LOADED ONCE
+	char *tok = strtok(curr_path, "\\");
+	while (tok != NULL) {
+		if (!pentry->is_directory) {
+			free(curr_path);
+			errno = ENOTDIR;
+			return -1;
+		}
+		uint32_t entries = 0;
+		struct actual_dir_entry_t *buffer = dir_load(pvolume, pentry->cluster_number, &entries);
+		if (buffer == NULL) {
+			free(curr_path);
+			return -1;
+		}
+		int found = 0;
+		for (uint32_t i = 0; i < entries && (buffer + i)->DIR_Name[0] != 0x00; ++i) {
+			struct actual_dir_entry_t *ent = buffer + i;
+			if (ent->DIR_Name[0] == 0xE5 || ent->DIR_Attr.ATTR_VOLUME_ID) {
+				continue;
+			}
+			// DIR[0] IS A KANJI
+			if (ent->DIR_Name[0] == 0x05) {
+				ent->DIR_Name[0] = 0xE5;
+			}
+			char name[13];
+			convert_entry_name(*ent, name);
+			if (strcmp(name, tok) == 0) {
+				fill_entry(ent, pentry);
+				found = 1;
+				break;
+			}
+		}
+		free(buffer);
+		if (!found) {
+			free(curr_path);
+			errno = ENOENT;
+			return -1;
+		}
+		tok = strtok(NULL, "\\");
+	}
+	free(curr_path);
+	return 0;
+}
+static int deleted_entry_valid(struct volume_t* pvolume, const struct actual_dir_entry_t* ent) {
+	uint32_t ClusterSize = pvolume->bpb.BPB_SecPerClus * pvolume->bpb.BPB_BytsPerSec;
+	uint32_t CountofClusters = data_clusters(pvolume->bpb);
+	uint16_t cluster = ent->DIR_FstClusLO;
+	// NAMES HAVE NO CONTROL CHARACTERS, FIRST ONE MAY BE A MARK
+	for (int i = 1; i < 11; ++i) {
+		if (ent->DIR_Name[i] < 0x20) {
+			return 0;
+		}
+	}
+	if (ent->DIR_Name[0] < 0x20 && ent->DIR_Name[0] != 0x05) {
+		return 0;
+	}
+	if (ent->DIR_FileSize > CountofClusters * ClusterSize) {
+		return 0;
+	}
+	// DIRS HAVE NO SIZE BUT ALWAYS A CLUSTER, FILES HAVE A CLUSTER IF THEY HAVE DATA
+	if (ent->DIR_Attr.ATTR_DIRECTORY && ent->DIR_FileSize != 0) {
+		return 0;
+	}
+	if (cluster == 0) {
+		return !ent->DIR_Attr.ATTR_DIRECTORY && ent->DIR_FileSize == 0;
+	}
+	return cluster >= 2 && (uint32_t)cluster - 2 < CountofClusters;
+}
+static int walk_dir(struct volume_t* pvolume, uint16_t cluster_number, const char* path, uint8_t* visited, int in_deleted, int flags, walk_callback_t callback, void* arg) {
+	uint32_t entries = 0;
+	struct actual_dir_entry_t *buffer = in_deleted ? deleted_dir_load(pvolume, cluster_number, &entries) : dir_load(pvolume, cluster_number, &entries);
+	// SKIP SUBTREES THAT CANNOT BE READ, E.G. LOOPED CHAINS OR REUSED CLUSTERS OF DELETED DIRS
+	if (buffer == NULL) {
+		return cluster_number == 0 || errno == ENOMEM ? -1 : 0;
+	}
+	char *curr_path = malloc(strlen(path) + 14);
+	if (curr_path == NULL) {
+		free(buffer);
+		errno = ENOMEM;
+		return -1;
+	}
+	int ret = 0;
+	for (uint32_t i = 0; i < entries && ret == 0; ++i) {
+		struct walk_entry_t went;
+		went.raw = *(buffer + i);
+		went.parent_cluster = cluster_number;
+		went.is_deleted = in_deleted;
+		// END OF DIR
+		if (went.raw.DIR_Name[0] == 0x00) {
+			break;
+		}
+		// SKIP VOLUME LABELS, LONG NAMES AND DOT ENTRIES
+		if (went.raw.DIR_Attr.ATTR_VOLUME_ID || went.raw.DIR_Name[0] == '.') {
+			continue;
+		}
+		if (went.raw.DIR_Name[0] == 0xE5) {
+			if (!(flags & WALK_DELETED)) {
+				continue;
+			}
+			went.is_deleted = 1;
+		}
+		// ROWS OF DELETED DIRS MAY BE GARBAGE, DROP THOSE THAT CANNOT BE ON THIS VOLUME
+		if (went.is_deleted && !deleted_entry_valid(pvolume, &went.raw)) {
+			continue;
+		}
+		convert_entry_name(went.raw, went.name);
+		// FIRST CHARACTER OF A DELETED ENTRY IS LOST
+		if (went.raw.DIR_Name[0] == 0xE5) {
+			went.name[0] = '?';
+		} else
+		// DIR[0] IS A KANJI
+		if (went.raw.DIR_Name[0] == 0x05) {
+			went.raw.DIR_Name[0] = 0xE5;
+			went.name[0] = (char)0xE5;
+		}
+		sprintf(curr_path, "%s\\%s", path, went.name);
+		went.path = curr_path;
+
+		ret = callback(&went, arg);
+		if (ret != 0 || !went.raw.DIR_Attr.ATTR_DIRECTORY) {
+			continue;
+		}
+		// DESCEND ONLY ONCE INTO EVERY DIR
+		uint16_t sub = went.raw.DIR_FstClusLO;
+		if (sub < 2 || (uint32_t)sub - 2 >= data_clusters(pvolume->bpb) || *(visited + sub)) {
+			continue;
+		}
+		// DELETED DIRS ARE WORTH READING ONLY IF THEIR FIRST CLUSTER IS STILL FREE
+		if (went.is_deleted && get_fat12_entry(pvolume->FAT1, pvolume->bpb.BPB_BytsPerSec * pvolume->bpb.BPB_FATSz16, sub) != 0) {
+			continue;
+		}
+		*(visited + sub) = 1;
+		ret = walk_dir(pvolume, sub, curr_path, visited, went.is_deleted, flags, callback, arg);
+	}
+	free(curr_path);
+	free(buffer);
+	return ret;
+}
+int volume_walk(struct volume_t* pvolume, int flags, walk_callback_t callback, void* arg) {
+	if (pvolume == NULL || pvolume->FAT1 == NULL || callback == NULL) {
+		errno = EFAULT;
+		return -1;
+	}
+	uint8_t *visited = calloc(data_clusters(pvolume->bpb) + 2, 1);
+	if (visited == NULL) {
+		errno = ENOMEM;
+		return -1;
+	}
+	int ret = walk_dir(pvolume, 0, "", visited, 0, flags, callback, arg);
+	free(visited);
+	return ret;
+}
+struct timestamp_t decode_timestamp(struct date_format_t date, struct time_format_t time, uint8_t tenth) {
+	struct timestamp_t ts;
+	ts.year = 1980 + date.year;
+	ts.month = date.month;
+	ts.day = date.day;
+	ts.hour = time.hour;
+	ts.minute = time.minute;
+	// TWO SECOND GRANULARITY, TENTH ADDS UP TO 199 HUNDREDTHS
+	ts.second = time.second * 2 + tenth / 100;
+	ts.millisecond = (tenth % 100) * 10;
+	return ts;
+}
+uint32_t timestamp_key(struct timestamp_t timestamp) {
+	// SAME LAYOUT AS ON DISK, DATE IN HIGH HALF SO KEYS SORT BY TIME
+	uint32_t year = timestamp.year < 1980 ? 0 : timestamp.year - 1980;
+	uint32_t date = (year > 127 ? 127 : year) << 9 | (timestamp.month & 0xF) << 5 | (timestamp.day & 0x1F);
+	uint32_t time = (timestamp.hour & 0x1F) << 11 | (timestamp.minute & 0x3F) << 5 | ((timestamp.second / 2) & 0x1F);
+	return date << 16 | time;
+}
 void print_fat_info(struct bpb_t bpb) {
 	uint32_t RootDirSectors = ((bpb.BPB_RootEntCnt * FAT_RECORD_SIZE) + (bpb.BPB_BytsPerSec - 1)) / bpb.BPB_BytsPerSec;
 	uint32_t TotalSec = (bpb.BPB_TotSec16 != 0) ? bpb.BPB_TotSec16 : bpb.BPB_TotSec32;
@@ -649,4 +1029,7 @@ void print_entry_info(struct dir_entry_t dir) {
 	printf("\tSystem file  : %s\n", dir.is_system ? "Yes" : "No");
 	printf("\tDirectory    : %s\n", dir.is_directory ? "Yes" : "No");
 	printf("\tArchive      : %s\n", dir.is_archived ? "Yes" : "No");
+	printf("Created: %04hu-%02hhu-%02hhu %02hhu:%02hhu:%02hhu\n", dir.created.year, dir.created.month, dir.created.day, dir.created.hour, dir.created.minute, dir.created.second);
+	printf("Modified: %04hu-%02hhu-%02hhu %02hhu:%02hhu:%02hhu\n", dir.modified.year, dir.modified.month, dir.modified.day, dir.modified.hour, dir.modified.minute, dir.modified.second);
+	printf("Accessed: %04hu-%02hhu-%02hhu\n", dir.accessed.year, dir.accessed.month, dir.accessed.day);
 }
\ No newline at end of file
@@ -10,6 +10,10 @@
 struct disk_t {
 	const char*			filename;
 	FILE*				handle;
+
+	// IMAGE ALREADY IN MEMORY
+	const uint8_t*		memory;
+	size_t				length;
 };
 struct volume_t {
 	struct disk_t*		pdisk;
@@ -23,10 +27,23 @@ struct dir_t {
 	uint16_t			curr_i;
 	uint16_t			cluster_number;
 };
+struct timestamp_t {
+	uint16_t			year;
+	uint8_t				month;
+	uint8_t				day;
+	uint8_t				hour;
+	uint8_t				minute;
+	uint8_t				second;
+	uint16_t			millisecond;
+};
 struct dir_entry_t {
 	char 				name[13];
 	uint32_t 			size;
 
+	struct timestamp_t	created;
+	struct timestamp_t	modified;
+	struct timestamp_t	accessed;
+
 	int 				is_archived;
 	int 				is_readonly;
 	int 				is_system;
@@ -44,6 +61,19 @@ struct clusters_chain_t {
 	uint16_t			*clusters;
 	uint32_t			size;
 };
+struct walk_entry_t {
+	const char*			path;
+	char 				name[13];
+	struct actual_dir_entry_t raw;
+
+	int 				is_deleted;
+	uint16_t			parent_cluster;
+};
+
+// WALK FLAGS
+#define WALK_DELETED    0x01
+
+typedef int (*walk_callback_t)(const struct walk_entry_t* pentry, void* arg);
 
 
 // FAT ADDRESSES
@@ -51,29 +81,48 @@ uint32_t fat1_addr(struct bpb_t bpb);
 uint32_t fat2_addr(struct bpb_t bpb);
 uint32_t root_addr(struct bpb_t bpb);
 uint32_t data_addr(struct bpb_t bpb);
+uint32_t data_clusters(struct bpb_t bpb);
 
 // FILE HANDLING
 struct disk_t* disk_open_from_file(const char* volume_file_name);
+struct disk_t* disk_open_from_memory(const void* buffer, size_t length);
 int disk_read(struct disk_t* pdisk, int32_t first_sector, void* buffer, int32_t sectors_to_read);
+const void* disk_view(struct disk_t* pdisk, int32_t first_sector, int32_t sectors_to_view);
 int disk_close(struct disk_t* pdisk);
 
 // FAT INIT
+int fat_check_bpb(struct bpb_t bpb);
 struct volume_t* fat_open(struct disk_t* pdisk, uint32_t first_sector);
 int fat_close(struct volume_t* pvolume);
 
 // FAT HELPER FUNCTIONS
+uint16_t get_fat12_entry(const void * const buffer, size_t size, uint16_t cluster);
+int set_fat12_entry(void * const buffer, size_t size, uint16_t cluster, uint16_t value);
 struct clusters_chain_t *get_chain_fat12(const void * const buffer, size_t size, uint16_t first_cluster);
+int cluster_read(struct volume_t* pvolume, uint16_t first_cluster, void* buffer, uint32_t clusters_to_read);
+int chain_read(struct volume_t* pvolume, const struct clusters_chain_t* chain, void* buffer);
 
 // POSIX FUNCTIONS
 struct file_t* file_open(struct volume_t* pvolume, const char* file_name);
 int file_close(struct file_t* stream);
 int32_t file_seek(struct file_t* stream, int32_t offset, int whence);
 size_t file_read(void *ptr, size_t size, size_t nmemb, struct file_t *stream);
+int file_stat(struct volume_t* pvolume, const char* file_name, struct dir_entry_t* pentry);
 
 // DIR
 struct dir_t* dir_open(struct volume_t* pvolume, const char* dir_path);
 int dir_close(struct dir_t* pdir);
 int dir_read(struct dir_t* pdir, struct dir_entry_t* pentry);
+void* dir_load(struct volume_t* pvolume, uint16_t cluster_number, uint32_t* entries);
+void* deleted_dir_load(struct volume_t* pvolume, uint16_t cluster_number, uint32_t* entries);
+void convert_entry_name(struct actual_dir_entry_t ent, char *dest);
+
+// TREE WALKING
+int volume_walk(struct volume_t* pvolume, int flags, walk_callback_t callback, void* arg);
+
+// TIMESTAMPS
+struct timestamp_t decode_timestamp(struct date_format_t date, struct time_format_t time, uint8_t tenth);
+uint32_t timestamp_key(struct timestamp_t timestamp);
 
 // PRINTING
 void print_fat_info(struct bpb_t bpb);
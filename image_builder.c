@@ -0,0 +1,496 @@
+#include "image_builder.h"
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <time.h>
+#include <dirent.h>
+#include <sys/stat.h>
+
+struct build_node_t {
+	char*					host_path;
+	struct actual_dir_entry_t	ent;
+	int 					is_directory;
+
+	struct build_node_t**	children;
+	uint32_t				size;
+	uint32_t				capacity;
+
+	uint16_t				first_cluster;
+	uint32_t				clusters;
+};
+struct build_ctx_t {
+	struct bpb_t			bpb;
+	uint32_t				cluster_size;
+	uint32_t				count_of_clusters;
+	uint16_t				next_cluster;
+
+	uint8_t*				fat;
+	size_t					fat_size;
+};
+
+static void free_node(struct build_node_t* node) {
+	if (node == NULL) {
+		return;
+	}
+	for (uint32_t i = 0; i < node->size; ++i) {
+		free_node(*(node->children + i));
+	}
+	free(node->children);
+	free(node->host_path);
+	free(node);
+}
+static void encode_time(time_t t, struct date_format_t* date, struct time_format_t* time) {
+	struct tm tm;
+	localtime_r(&t, &tm);
+	// FAT CANNOT GO BEFORE 1980
+	if (tm.tm_year < 80) {
+		date->date = (1 << 5) | 1;
+		time->time = 0;
+		return;
+	}
+	date->date = 0;
+	date->year = tm.tm_year - 80 > 127 ? 127 : tm.tm_year - 80;
+	date->month = tm.tm_mon + 1;
+	date->day = tm.tm_mday;
+	time->time = 0;
+	time->hour = tm.tm_hour;
+	time->minute = tm.tm_min;
+	time->second = tm.tm_sec / 2;
+}
+static int valid_short_char(char c) {
+	return isalnum((unsigned char)c) || strchr("!#$%&'()-@^_`{}~", c) != NULL;
+}
+// 8.3 NAME, LOSSY NAMES GET A ~N TAIL UNIQUE WITHIN DIR
+static int make_short_name(struct build_node_t* parent, const char* host_name, unsigned char* dest) {
+	const char *dot = strrchr(host_name, '.');
+	if (dot == host_name) {
+		dot = NULL;
+	}
+	size_t base_len = dot ? (size_t)(dot - host_name) : strlen(host_name);
+	char base[9] = { 0 };
+	char ext[4] = { 0 };
+	size_t n = 0;
+	int lossy = 0;
+	for (size_t i = 0; i < base_len; ++i) {
+		char c = *(host_name + i);
+		if (c == '.' || c == ' ') {
+			lossy = 1;
+			continue;
+		}
+		if (n == 8) {
+			lossy = 1;
+			break;
+		}
+		base[n++] = valid_short_char(c) ? toupper((unsigned char)c) : (lossy = 1, '_');
+	}
+	if (n == 0) {
+		base[n++] = '_';
+		lossy = 1;
+	}
+	n = 0;
+	for (const char *p = dot ? dot + 1 : ""; *p != '\0'; ++p) {
+		if (*p == ' ') {
+			lossy = 1;
+			continue;
+		}
+		if (n == 3) {
+			lossy = 1;
+			break;
+		}
+		ext[n++] = valid_short_char(*p) ? toupper((unsigned char)*p) : (lossy = 1, '_');
+	}
+	for (uint32_t tail = lossy ? 1 : 0; tail < 1000000; ++tail) {
+		char name[16];
+		if (tail == 0) {
+			strcpy(name, base);
+		} else {
+			char suffix[16];
+			int suffix_len = snprintf(suffix, sizeof(suffix), "~%u", tail);
+			int keep = strlen(base) < (size_t)(8 - suffix_len) ? (int)strlen(base) : 8 - suffix_len;
+			memcpy(name, base, keep);
+			strcpy(name + keep, suffix);
+		}
+		memset(dest, ' ', 11);
+		memcpy(dest, name, strlen(name));
+		memcpy(dest + 8, ext, strlen(ext));
+		// FIRST BYTE 0xE5 MEANS A FREE ENTRY
+		if (dest[0] == 0xE5) {
+			dest[0] = 0x05;
+		}
+		int taken = 0;
+		for (uint32_t i = 0; i < parent->size && !taken; ++i) {
+			taken = memcmp((*(parent->children + i))->ent.DIR_Name, dest, 11) == 0;
+		}
+		if (!taken) {
+			return 0;
+		}
+	}
+	errno = EEXIST;
+	return -1;
+}
+static int compare_names(const void* a, const void* b) {
+	const char *na = (const char *)(*(struct build_node_t * const *)a)->ent.DIR_Name;
+	const char *nb = (const char *)(*(struct build_node_t * const *)b)->ent.DIR_Name;
+	return memcmp(na, nb, 11);
+}
+static int scan_dir(struct build_node_t* node) {
+	DIR *dir = opendir(node->host_path);
+	if (dir == NULL) {
+		return -1;
+	}
+	struct dirent *de;
+	while ((de = readdir(dir)) != NULL) {
+		if (strcmp(de->d_name, ".") == 0 || strcmp(de->d_name, "..") == 0) {
+			continue;
+		}
+		struct build_node_t *child = calloc(1, sizeof(struct build_node_t));
+		if (child == NULL) {
+			closedir(dir);
+			errno = ENOMEM;
+			return -1;
+		}
+		child->host_path = malloc(strlen(node->host_path) + strlen(de->d_name) + 2);
+		if (child->host_path == NULL) {
+			free(child);
+			closedir(dir);
+			errno = ENOMEM;
+			return -1;
+		}
+		sprintf(child->host_path, "%s/%s", node->host_path, de->d_name);
+		struct stat st;
+		// ONLY REGULAR FILES AND DIRS ARE COPIED, SYMLINKS ARE NOT FOLLOWED SO THEY CANNOT LOOP
+		if (lstat(child->host_path, &st) != 0 || (!S_ISREG(st.st_mode) && !S_ISDIR(st.st_mode))) {
+			free_node(child);
+			continue;
+		}
+		if (S_ISREG(st.st_mode) && (uint64_t)st.st_size > 0xFFFFFFFF) {
+			free_node(child);
+			closedir(dir);
+			errno = EFBIG;
+			return -1;
+		}
+		child->is_directory = S_ISDIR(st.st_mode);
+		if (make_short_name(node, de->d_name, child->ent.DIR_Name) != 0) {
+			free_node(child);
+			closedir(dir);
+			return -1;
+		}
+		child->ent.DIR_Attr.ATTR_DIRECTORY = child->is_directory;
+		child->ent.DIR_Attr.ATTR_ARCHIVE = !child->is_directory;
+		child->ent.DIR_Attr.ATTR_READ_ONLY = !(st.st_mode & S_IWUSR);
+		child->ent.DIR_FileSize = child->is_directory ? 0 : (uint32_t)st.st_size;
+		encode_time(st.st_mtime, &child->ent.DIR_WrtDate, &child->ent.DIR_WrtTime);
+		encode_time(st.st_mtime, &child->ent.DIR_CrtDate, &child->ent.DIR_CrtTime);
+		struct time_format_t unused;
+		encode_time(st.st_atime, &child->ent.DIR_LstAccDate, &unused);
+
+		// GROW ARRAY
+		if (node->size == node->capacity) {
+			uint32_t capacity = node->capacity ? node->capacity * 2 : 16;
+			struct build_node_t **children = realloc(node->children, capacity * sizeof(struct build_node_t *));
+			if (children == NULL) {
+				free_node(child);
+				closedir(dir);
+				errno = ENOMEM;
+				return -1;
+			}
+			node->children = children;
+			node->capacity = capacity;
+		}
+		*(node->children + node->size++) = child;
+	}
+	closedir(dir);
+	// SAME INPUT, SAME IMAGE
+	if (node->size > 0) {
+		qsort(node->children, node->size, sizeof(struct build_node_t *), compare_names);
+	}
+	for (uint32_t i = 0; i < node->size; ++i) {
+		if ((*(node->children + i))->is_directory && scan_dir(*(node->children + i)) != 0) {
+			return -1;
+		}
+	}
+	return 0;
+}
+// CONTIGUOUS CLUSTERS FOR EVERY NODE, DIR FIRST, THEN ITS CONTENT
+static int layout_node(struct build_ctx_t* ctx, struct build_node_t* node) {
+	if (node->is_directory) {
+		uint32_t bytes = (node->size + 2) * FAT_RECORD_SIZE;
+		node->clusters = (bytes + ctx->cluster_size - 1) / ctx->cluster_size;
+	} else {
+		node->clusters = (node->ent.DIR_FileSize + ctx->cluster_size - 1) / ctx->cluster_size;
+	}
+	if (node->clusters > 0) {
+		if (ctx->next_cluster - 2 + node->clusters > ctx->count_of_clusters) {
+			errno = ENOSPC;
+			return -1;
+		}
+		node->first_cluster = ctx->next_cluster;
+		for (uint32_t i = 0; i < node->clusters; ++i) {
+			uint16_t cluster = node->first_cluster + i;
+			set_fat12_entry(ctx->fat, ctx->fat_size, cluster, i + 1 == node->clusters ? 0x0FFF : cluster + 1);
+		}
+		ctx->next_cluster += node->clusters;
+		node->ent.DIR_FstClusLO = node->first_cluster;
+	}
+	for (uint32_t i = 0; node->is_directory && i < node->size; ++i) {
+		if (layout_node(ctx, *(node->children + i)) != 0) {
+			return -1;
+		}
+	}
+	return 0;
+}
+static int fill_bpb(struct bpb_t* bpb, const struct image_options_t* options) {
+	memset(bpb, 0, sizeof(struct bpb_t));
+	memcpy(bpb->BS_jmpBoot, "\xEB\x3C\x90", 3);
+	memcpy(bpb->BS_OEMName, "MSWIN4.1", 8);
+	bpb->BPB_BytsPerSec = BLOCK_SIZE;
+	bpb->BPB_SecPerClus = options->sectors_per_cluster ? options->sectors_per_cluster : 1;
+	bpb->BPB_RsvdSecCnt = 1;
+	bpb->BPB_NumFATs = options->num_fats ? options->num_fats : 2;
+	bpb->BPB_RootEntCnt = options->root_entries ? options->root_entries : 224;
+	bpb->BPB_TotSec16 = options->total_sectors ? options->total_sectors : 2880;
+	bpb->BPB_Media = options->media ? options->media : 0xF0;
+	bpb->BPB_SecPerTrk = options->sectors_per_track ? options->sectors_per_track : 18;
+	bpb->BPB_NumHeads = options->heads ? options->heads : 2;
+	bpb->BS_BootSig = 0x29;
+	bpb->BS_VolID = options->volume_id;
+	memset(bpb->BS_VolLab, ' ', 11);
+	if (options->label != NULL) {
+		for (size_t i = 0; i < 11 && *(options->label + i) != '\0'; ++i) {
+			bpb->BS_VolLab[i] = toupper((unsigned char)*(options->label + i));
+		}
+	} else {
+		memcpy(bpb->BS_VolLab, "NO NAME", 7);
+	}
+	memcpy(bpb->BS_FilSysType, "FAT12   ", 8);
+	bpb->BS_Signature = SIG;
+
+	// FAT SIZE DEPENDS ON CLUSTER COUNT WHICH DEPENDS ON FAT SIZE
+	bpb->BPB_FATSz16 = 1;
+	while (1) {
+		uint32_t clusters = data_clusters(*bpb) + 2;
+		uint16_t needed = (clusters * 3 / 2 + 1 + BLOCK_SIZE - 1) / BLOCK_SIZE;
+		if (needed <= bpb->BPB_FATSz16) {
+			break;
+		}
+		bpb->BPB_FATSz16 = needed;
+	}
+	if (fat_check_bpb(*bpb) != 0) {
+		return -1;
+	}
+	return 0;
+}
+static int write_zeros(FILE* out, uint8_t* buffer, size_t bytes) {
+	memset(buffer, 0, bytes < BUILDER_BUFFER_SIZE ? bytes : BUILDER_BUFFER_SIZE);
+	while (bytes > 0) {
+		size_t chunk = bytes < BUILDER_BUFFER_SIZE ? bytes : BUILDER_BUFFER_SIZE;
+		if (fwrite(buffer, 1, chunk, out) != chunk) {
+			errno = EIO;
+			return -1;
+		}
+		bytes -= chunk;
+	}
+	return 0;
+}
+static void dir_entries(const struct build_node_t* node, uint16_t parent_cluster, struct actual_dir_entry_t* dest) {
+	uint32_t i = 0;
+	if (parent_cluster != 0xFFFF) {
+		// . AND ..
+		*(dest + i) = node->ent;
+		memcpy((dest + i)->DIR_Name, ".          ", 11);
+		i++;
+		*(dest + i) = node->ent;
+		memcpy((dest + i)->DIR_Name, "..         ", 11);
+		(dest + i)->DIR_FstClusLO = parent_cluster;
+		i++;
+	}
+	for (uint32_t j = 0; j < node->size; ++j) {
+		*(dest + i++) = (*(node->children + j))->ent;
+	}
+}
+static int write_node(FILE* out, struct build_ctx_t* ctx, struct build_node_t* node, uint16_t parent_cluster, uint8_t* buffer) {
+	size_t bytes = (size_t)node->clusters * ctx->cluster_size;
+	if (node->is_directory) {
+		// DIR FITS INTO BUFFER ONLY IF IT IS SMALL ENOUGH
+		uint8_t *data = bytes <= BUILDER_BUFFER_SIZE ? buffer : calloc(bytes, 1);
+		if (data == NULL) {
+			errno = ENOMEM;
+			return -1;
+		}
+		memset(data, 0, bytes);
+		dir_entries(node, parent_cluster, (struct actual_dir_entry_t *)data);
+		size_t written = fwrite(data, 1, bytes, out);
+		if (data != buffer) {
+			free(data);
+		}
+		if (written != bytes) {
+			errno = EIO;
+			return -1;
+		}
+		return 0;
+	}
+	FILE *in = fopen(node->host_path, "rb");
+	if (in == NULL) {
+		return -1;
+	}
+	size_t left = node->ent.DIR_FileSize;
+	while (left > 0) {
+		size_t chunk = left < BUILDER_BUFFER_SIZE ? left : BUILDER_BUFFER_SIZE;
+		// FILE SHRANK SINCE IT WAS SCANNED
+		if (fread(buffer, 1, chunk, in) != chunk || fwrite(buffer, 1, chunk, out) != chunk) {
+			fclose(in);
+			errno = EIO;
+			return -1;
+		}
+		left -= chunk;
+	}
+	fclose(in);
+	// PAD LAST CLUSTER
+	if (write_zeros(out, buffer, bytes - node->ent.DIR_FileSize) != 0) {
+		return -1;
+	}
+	return 0;
+}
+// DIRS AND FILES ARE WRITTEN IN CLUSTER ORDER, PARENTS ARE NEEDED FOR ..
+static int write_tree(FILE* out, struct build_ctx_t* ctx, struct build_node_t* node, uint16_t parent_cluster, uint8_t* buffer) {
+	if (node->clusters > 0 && write_node(out, ctx, node, parent_cluster, buffer) != 0) {
+		return -1;
+	}
+	for (uint32_t i = 0; node->is_directory && i < node->size; ++i) {
+		if (write_tree(out, ctx, *(node->children + i), node->first_cluster, buffer) != 0) {
+			return -1;
+		}
+	}
+	return 0;
+}
+static int build(struct build_ctx_t* ctx, struct build_node_t* root, const char* image_file, const struct image_options_t* options) {
+	struct bpb_t bpb = ctx->bpb;
+	// ROOT DIR HAS A FIXED SIZE
+	if (root->size + (options->label != NULL) > bpb.BPB_RootEntCnt) {
+		errno = ENOSPC;
+		return -1;
+	}
+	ctx->fat_size = bpb.BPB_BytsPerSec * bpb.BPB_FATSz16;
+	ctx->fat = calloc(ctx->fat_size, 1);
+	if (ctx->fat == NULL) {
+		errno = ENOMEM;
+		return -1;
+	}
+	set_fat12_entry(ctx->fat, ctx->fat_size, 0, 0x0F00 | bpb.BPB_Media);
+	set_fat12_entry(ctx->fat, ctx->fat_size, 1, 0x0FFF);
+	ctx->next_cluster = 2;
+	for (uint32_t i = 0; i < root->size; ++i) {
+		if (layout_node(ctx, *(root->children + i)) != 0) {
+			return -1;
+		}
+	}
+	// ROOT DIR
+	size_t RootSize = bpb.BPB_RootEntCnt * FAT_RECORD_SIZE;
+	struct actual_dir_entry_t *root_dir = calloc(RootSize, 1);
+	uint8_t *buffer = malloc(BUILDER_BUFFER_SIZE);
+	if (root_dir == NULL || buffer == NULL) {
+		free(root_dir);
+		free(buffer);
+		errno = ENOMEM;
+		return -1;
+	}
+	struct actual_dir_entry_t *first = root_dir;
+	if (options->label != NULL) {
+		memcpy(first->DIR_Name, bpb.BS_VolLab, 11);
+		first->DIR_Attr.ATTR_VOLUME_ID = 1;
+		first++;
+	}
+	dir_entries(root, 0xFFFF, first);
+
+	FILE *out = fopen(image_file, "wb");
+	if (out == NULL) {
+		free(root_dir);
+		free(buffer);
+		return -1;
+	}
+	setvbuf(out, NULL, _IOFBF, BUILDER_BUFFER_SIZE);
+
+	// ONE SEQUENTIAL PASS: BOOT SECTOR, FATS, ROOT, DATA, FREE SPACE
+	int ret = 0;
+	if (fwrite(&bpb, 1, BLOCK_SIZE, out) != BLOCK_SIZE) {
+		errno = EIO;
+		ret = -1;
+	}
+	if (ret == 0 && write_zeros(out, buffer, fat1_addr(bpb) - BLOCK_SIZE) != 0) {
+		ret = -1;
+	}
+	for (int i = 0; ret == 0 && i < bpb.BPB_NumFATs; ++i) {
+		if (fwrite(ctx->fat, 1, ctx->fat_size, out) != ctx->fat_size) {
+			errno = EIO;
+			ret = -1;
+		}
+	}
+	if (ret == 0 && fwrite(root_dir, 1, RootSize, out) != RootSize) {
+		errno = EIO;
+		ret = -1;
+	}
+	for (uint32_t i = 0; ret == 0 && i < root->size; ++i) {
+		ret = write_tree(out, ctx, *(root->children + i), 0, buffer);
+	}
+	uint32_t TotalSec = bpb.BPB_TotSec16 != 0 ? bpb.BPB_TotSec16 : bpb.BPB_TotSec32;
+	size_t tail = (size_t)TotalSec * BLOCK_SIZE - data_addr(bpb) - (size_t)(ctx->next_cluster - 2) * ctx->cluster_size;
+	if (ret == 0 && write_zeros(out, buffer, tail) != 0) {
+		ret = -1;
+	}
+	// FIRST ERROR WINS, FCLOSE CAN STILL FAIL ON FLUSH
+	if (fclose(out) != 0 && ret == 0) {
+		errno = EIO;
+		ret = -1;
+	}
+	free(root_dir);
+	free(buffer);
+	if (ret != 0) {
+		// REMOVE MUST NOT HIDE THE ACTUAL ERROR
+		int error = errno;
+		remove(image_file);
+		errno = error;
+	}
+	return ret;
+}
+int image_build(const char* source_dir, const char* image_file, const struct image_options_t* options) {
+	if (source_dir == NULL || image_file == NULL) {
+		errno = EFAULT;
+		return -1;
+	}
+	struct image_options_t defaults;
+	memset(&defaults, 0, sizeof(defaults));
+	if (options == NULL) {
+		options = &defaults;
+	}
+	struct build_ctx_t ctx;
+	memset(&ctx, 0, sizeof(ctx));
+	if (fill_bpb(&ctx.bpb, options) != 0) {
+		return -1;
+	}
+	ctx.cluster_size = ctx.bpb.BPB_BytsPerSec * ctx.bpb.BPB_SecPerClus;
+	ctx.count_of_clusters = data_clusters(ctx.bpb);
+
+	// WHOLE TREE IS SCANNED BEFORE ANYTHING IS WRITTEN
+	struct build_node_t *root = calloc(1, sizeof(struct build_node_t));
+	if (root == NULL) {
+		errno = ENOMEM;
+		return -1;
+	}
+	root->is_directory = 1;
+	root->host_path = malloc(strlen(source_dir) + 1);
+	if (root->host_path == NULL) {
+		free(root);
+		errno = ENOMEM;
+		return -1;
+	}
+	strcpy(root->host_path, source_dir);
+
+	int ret = scan_dir(root);
+	if (ret == 0) {
+		ret = build(&ctx, root, image_file, options);
+	}
+	free(ctx.fat);
+	free_node(root);
+	return ret;
+}
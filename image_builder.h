@@ -0,0 +1,25 @@
+#ifndef __IMAGE_BUILDER_H__
+#define __IMAGE_BUILDER_H__
+
+#include "file_reader.h"
+
+#define BUILDER_BUFFER_SIZE (1024 * 1024)
+
+// ZERO FIELDS FALL BACK TO A 1.44 MB FLOPPY
+struct image_options_t {
+	uint16_t			total_sectors;
+	uint8_t				sectors_per_cluster;
+	uint16_t			root_entries;
+	uint8_t				num_fats;
+	uint8_t				media;
+	uint16_t			sectors_per_track;
+	uint16_t			heads;
+
+	const char*			label;
+	uint32_t			volume_id;
+};
+
+// BUILDING
+int image_build(const char* source_dir, const char* image_file, const struct image_options_t* options);
+
+#endif
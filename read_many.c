@@ -0,0 +1,173 @@
+#include "read_many.h"
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+struct read_segment_t {
+	uint16_t			cluster;
+	uint32_t			request;
+	uint32_t			offset;
+	uint32_t			size;
+};
+
+static int compare_segments(const void* a, const void* b) {
+	const struct read_segment_t *sa = (const struct read_segment_t *)a;
+	const struct read_segment_t *sb = (const struct read_segment_t *)b;
+	if (sa->cluster != sb->cluster) {
+		return sa->cluster - sb->cluster;
+	}
+	return sa->request < sb->request ? -1 : sa->request > sb->request;
+}
+// SPLIT REQUEST INTO PER CLUSTER SEGMENTS
+static int plan_request(struct volume_t* pvolume, struct read_request_t* request, uint32_t index, uint16_t* stamps, uint16_t stamp, struct read_segment_t** segments, size_t* size, size_t* capacity) {
+	uint32_t ClusterSize = pvolume->bpb.BPB_SecPerClus * pvolume->bpb.BPB_BytsPerSec;
+	uint32_t CountofClusters = data_clusters(pvolume->bpb);
+	size_t FatSize = pvolume->bpb.BPB_BytsPerSec * pvolume->bpb.BPB_FATSz16;
+
+	struct dir_entry_t ent;
+	if (request->path != NULL) {
+		if (file_stat(pvolume, request->path, &ent) != 0) {
+			return errno;
+		}
+	} else if (request->entry != NULL) {
+		ent = *request->entry;
+	} else {
+		return EFAULT;
+	}
+	if (ent.is_directory) {
+		return EISDIR;
+	}
+	if (request->buffer == NULL && request->callback == NULL) {
+		return EFAULT;
+	}
+	uint32_t bytes = ent.size;
+	if (request->buffer != NULL && request->capacity < bytes) {
+		bytes = request->capacity;
+	}
+	uint16_t cluster = ent.cluster_number;
+	for (uint32_t offset = 0; offset < bytes; offset += ClusterSize) {
+		if (cluster < 2 || (uint32_t)cluster - 2 >= CountofClusters) {
+			return EIO;
+		}
+		// CLUSTER ALREADY PLANNED FOR THIS REQUEST, CHAIN LOOPS
+		if (*(stamps + cluster) == stamp) {
+			return ELOOP;
+		}
+		*(stamps + cluster) = stamp;
+		// GROW ARRAY
+		if (*size == *capacity) {
+			size_t new_capacity = *capacity ? *capacity * 2 : 256;
+			struct read_segment_t *new_segments = realloc(*segments, new_capacity * sizeof(struct read_segment_t));
+			if (new_segments == NULL) {
+				return ENOMEM;
+			}
+			*segments = new_segments;
+			*capacity = new_capacity;
+		}
+		struct read_segment_t *segment = *segments + (*size)++;
+		segment->cluster = cluster;
+		segment->request = index;
+		segment->offset = offset;
+		segment->size = bytes - offset < ClusterSize ? bytes - offset : ClusterSize;
+		cluster = get_fat12_entry(pvolume->FAT1, FatSize, cluster);
+	}
+	return 0;
+}
+int file_read_many(struct volume_t* pvolume, struct read_request_t* requests, size_t count) {
+	if (pvolume == NULL || pvolume->FAT1 == NULL || (requests == NULL && count > 0)) {
+		errno = EFAULT;
+		return -1;
+	}
+	uint32_t ClusterSize = pvolume->bpb.BPB_SecPerClus * pvolume->bpb.BPB_BytsPerSec;
+	uint32_t BufferClusters = READ_MANY_BUFFER_SIZE > ClusterSize ? READ_MANY_BUFFER_SIZE / ClusterSize : 1;
+
+	uint32_t clusters = data_clusters(pvolume->bpb) + 2;
+
+	// CLUSTERS SEEN IN THE CURRENT REQUEST HOLD ITS STAMP
+	uint16_t *stamps = calloc(clusters, sizeof(uint16_t));
+	if (stamps == NULL) {
+		errno = ENOMEM;
+		return -1;
+	}
+	uint16_t stamp = 0;
+
+	// RESOLVE ALL EXTENTS UP FRONT
+	struct read_segment_t *segments = NULL;
+	size_t size = 0;
+	size_t capacity = 0;
+	for (size_t i = 0; i < count; ++i) {
+		struct read_request_t *request = requests + i;
+		size_t first = size;
+		if (++stamp == 0) {
+			memset(stamps, 0, clusters * sizeof(uint16_t));
+			stamp = 1;
+		}
+		request->read = 0;
+		request->error = plan_request(pvolume, request, i, stamps, stamp, &segments, &size, &capacity);
+		// BROKEN REQUEST DOES NOT READ ANYTHING
+		if (request->error != 0) {
+			size = first;
+		}
+	}
+	free(stamps);
+	uint8_t *buffer = malloc(BufferClusters * ClusterSize);
+	if (buffer == NULL) {
+		free(segments);
+		errno = ENOMEM;
+		return -1;
+	}
+	// ONE SWEEP IN DISK ORDER
+	if (size > 0) {
+		qsort(segments, size, sizeof(struct read_segment_t), compare_segments);
+	}
+	size_t i = 0;
+	while (i < size) {
+		// MERGE NEARBY CLUSTERS, ACROSS FILES TOO
+		uint16_t first = (segments + i)->cluster;
+		size_t end = i + 1;
+		while (end < size
+			&& (segments + end)->cluster - (segments + end - 1)->cluster <= READ_MANY_MAX_GAP + 1
+			&& (uint32_t)((segments + end)->cluster - first) < BufferClusters) {
+			end++;
+		}
+		uint32_t run = (segments + end - 1)->cluster - first + 1;
+		const uint8_t *data = disk_view(pvolume->pdisk, (data_addr(pvolume->bpb) + (first - 2) * ClusterSize) / BLOCK_SIZE, run * ClusterSize / BLOCK_SIZE);
+		int error = 0;
+		if (data == NULL) {
+			data = buffer;
+			if (cluster_read(pvolume, first, buffer, run) == -1) {
+				error = errno;
+			}
+		}
+		// SCATTER
+		for (; i < end; ++i) {
+			struct read_segment_t *segment = segments + i;
+			struct read_request_t *request = requests + segment->request;
+			if (request->error != 0) {
+				continue;
+			}
+			if (error != 0) {
+				request->error = error;
+				continue;
+			}
+			const uint8_t *src = data + (segment->cluster - first) * ClusterSize;
+			if (request->buffer != NULL) {
+				memcpy((uint8_t *)request->buffer + segment->offset, src, segment->size);
+			} else if (request->callback(request->arg, segment->offset, src, segment->size) != 0) {
+				request->error = ECANCELED;
+				continue;
+			}
+			request->read += segment->size;
+		}
+	}
+	free(buffer);
+	free(segments);
+
+	for (size_t j = 0; j < count; ++j) {
+		if ((requests + j)->error != 0) {
+			errno = (requests + j)->error;
+			return -1;
+		}
+	}
+	return 0;
+}
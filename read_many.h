@@ -0,0 +1,31 @@
+#ifndef __READ_MANY_H__
+#define __READ_MANY_H__
+
+#include "file_reader.h"
+
+// LARGEST SINGLE READ AND FREE CLUSTERS READ THROUGH RATHER THAN SEEKED OVER
+#define READ_MANY_BUFFER_SIZE   (1024 * 1024)
+#define READ_MANY_MAX_GAP       8
+
+// DATA MAY ARRIVE OUT OF ORDER, OFFSET TELLS WHERE IT BELONGS
+typedef int (*read_callback_t)(void* arg, uint32_t offset, const void* data, uint32_t size);
+
+struct read_request_t {
+	// PATH, OR ENTRY WHEN PATH IS NULL
+	const char*					path;
+	const struct dir_entry_t*	entry;
+
+	// BUFFER, OR CALLBACK WHEN BUFFER IS NULL
+	void*						buffer;
+	size_t						capacity;
+	read_callback_t				callback;
+	void*						arg;
+
+	size_t						read;
+	int 						error;
+};
+
+// BATCH READING
+int file_read_many(struct volume_t* pvolume, struct read_request_t* requests, size_t count);
+
+#endif
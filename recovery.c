@@ -0,0 +1,150 @@
+#include "recovery.h"
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+static void estimate_entry(struct volume_t* pvolume, struct deleted_entry_t* pentry) {
+	uint32_t ClusterSize = pvolume->bpb.BPB_SecPerClus * pvolume->bpb.BPB_BytsPerSec;
+	uint32_t CountofClusters = data_clusters(pvolume->bpb);
+	size_t FatSize = pvolume->bpb.BPB_BytsPerSec * pvolume->bpb.BPB_FATSz16;
+
+	pentry->clusters = (pentry->size + ClusterSize - 1) / ClusterSize;
+	pentry->free_clusters = 0;
+	// DIR SIZE IS NOT STORED, IT SPANS FREE CLUSTERS UP TO ITS END MARK
+	if (pentry->is_directory) {
+		uint32_t entries = 0;
+		void *dir = deleted_dir_load(pvolume, pentry->cluster_number, &entries);
+		// FIRST CLUSTER REUSED OR OVERWRITTEN
+		if (dir == NULL) {
+			pentry->clusters = 1;
+			pentry->recoverability = RECOVERY_NONE;
+			return;
+		}
+		pentry->clusters = entries * FAT_RECORD_SIZE / ClusterSize;
+		free(dir);
+	}
+
+	// NOTHING TO RECOVER
+	if (pentry->clusters == 0) {
+		pentry->recoverability = RECOVERY_FULL;
+		return;
+	}
+	// DELETED FILES ARE ASSUMED TO BE CONTIGUOUS, COUNT FREE CLUSTERS IN A ROW
+	uint32_t cluster = pentry->cluster_number;
+	while (pentry->free_clusters < pentry->clusters
+		&& cluster >= 2
+		&& cluster - 2 < CountofClusters
+		&& get_fat12_entry(pvolume->FAT1, FatSize, cluster) == 0x0000) {
+		pentry->free_clusters++;
+		cluster++;
+	}
+	if (pentry->free_clusters == pentry->clusters) {
+		pentry->recoverability = RECOVERY_FULL;
+	} else if (pentry->free_clusters > 0) {
+		pentry->recoverability = RECOVERY_PARTIAL;
+	} else {
+		pentry->recoverability = RECOVERY_NONE;
+	}
+}
+static int collect_entry(const struct walk_entry_t* pentry, void* arg) {
+	struct recovery_t *precovery = (struct recovery_t *)arg;
+	if (!pentry->is_deleted) {
+		return 0;
+	}
+	// GROW ARRAY
+	if (precovery->size == precovery->capacity) {
+		uint32_t capacity = precovery->capacity ? precovery->capacity * 2 : 16;
+		struct deleted_entry_t *entries = realloc(precovery->entries, capacity * sizeof(struct deleted_entry_t));
+		if (entries == NULL) {
+			errno = ENOMEM;
+			return -1;
+		}
+		precovery->entries = entries;
+		precovery->capacity = capacity;
+	}
+	struct deleted_entry_t *dent = precovery->entries + precovery->size;
+	dent->path = malloc(strlen(pentry->path) + 1);
+	if (dent->path == NULL) {
+		errno = ENOMEM;
+		return -1;
+	}
+	strcpy(dent->path, pentry->path);
+	strcpy(dent->name, pentry->name);
+	dent->size = pentry->raw.DIR_FileSize;
+	dent->is_directory = pentry->raw.DIR_Attr.ATTR_DIRECTORY;
+	dent->cluster_number = pentry->raw.DIR_FstClusLO;
+	dent->parent_cluster = pentry->parent_cluster;
+	estimate_entry(precovery->pvolume, dent);
+	precovery->size++;
+	return 0;
+}
+struct recovery_t* recovery_scan(struct volume_t* pvolume) {
+	if (pvolume == NULL || pvolume->FAT1 == NULL) {
+		errno = EFAULT;
+		return NULL;
+	}
+	struct recovery_t *precovery = calloc(1, sizeof(struct recovery_t));
+	if (precovery == NULL) {
+		errno = ENOMEM;
+		return NULL;
+	}
+	precovery->pvolume = pvolume;
+	// SINGLE PASS OVER DIR TREE
+	if (volume_walk(pvolume, WALK_DELETED, collect_entry, precovery) != 0) {
+		recovery_close(precovery);
+		return NULL;
+	}
+	return precovery;
+}
+int recovery_close(struct recovery_t* precovery) {
+	if (precovery == NULL) {
+		errno = EFAULT;
+		return -1;
+	}
+	for (uint32_t i = 0; i < precovery->size; ++i) {
+		free((precovery->entries + i)->path);
+	}
+	free(precovery->entries);
+	free(precovery);
+	return 0;
+}
+struct file_t* recovery_open(struct recovery_t* precovery, uint32_t index) {
+	if (precovery == NULL || precovery->pvolume == NULL) {
+		errno = EFAULT;
+		return NULL;
+	}
+	if (index >= precovery->size) {
+		errno = EINVAL;
+		return NULL;
+	}
+	struct deleted_entry_t *dent = precovery->entries + index;
+	if (dent->recoverability == RECOVERY_NONE) {
+		errno = ENODATA;
+		return NULL;
+	}
+	uint32_t ClusterSize = precovery->pvolume->bpb.BPB_SecPerClus * precovery->pvolume->bpb.BPB_BytsPerSec;
+	uint32_t available = dent->free_clusters * ClusterSize;
+
+	struct file_t *pFile = malloc(sizeof(struct file_t));
+	if (pFile == NULL) {
+		errno = ENOMEM;
+		return NULL;
+	}
+	pFile->file = malloc(available ? available : 1);
+	if (pFile->file == NULL) {
+		free(pFile);
+		errno = ENOMEM;
+		return NULL;
+	}
+	// ONLY THE FREE PART OF DATA IS TRUSTED
+	pFile->size = dent->is_directory || dent->size > available ? available : dent->size;
+
+	// READ ALL FREE CLUSTERS AT ONCE
+	if (dent->free_clusters > 0 && cluster_read(precovery->pvolume, dent->cluster_number, pFile->file, dent->free_clusters) == -1) {
+		free(pFile->file);
+		free(pFile);
+		return NULL;
+	}
+	pFile->pos = pFile->file;
+	return pFile;
+}
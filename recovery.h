@@ -0,0 +1,37 @@
+#ifndef __RECOVERY_H__
+#define __RECOVERY_H__
+
+#include "file_reader.h"
+
+// RECOVERABILITY
+#define RECOVERY_NONE       0
+#define RECOVERY_PARTIAL    1
+#define RECOVERY_FULL       2
+
+struct deleted_entry_t {
+	char*				path;
+	char 				name[13];
+	uint32_t 			size;
+	int 				is_directory;
+
+	uint16_t			cluster_number;
+	uint16_t			parent_cluster;
+
+	// CLUSTERS NEEDED BY SIZE / FREE CLUSTERS FOUND IN A ROW
+	uint32_t			clusters;
+	uint32_t			free_clusters;
+	int 				recoverability;
+};
+struct recovery_t {
+	struct volume_t*		pvolume;
+	struct deleted_entry_t*	entries;
+	uint32_t				size;
+	uint32_t				capacity;
+};
+
+// RECOVERY
+struct recovery_t* recovery_scan(struct volume_t* pvolume);
+int recovery_close(struct recovery_t* precovery);
+struct file_t* recovery_open(struct recovery_t* precovery, uint32_t index);
+
+#endif
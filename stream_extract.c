@@ -0,0 +1,310 @@
+#include "stream_extract.h"
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+struct stream_node_t {
+	struct extract_entry_t	entry;
+	char*					path;
+
+	// CLUSTERS OF THIS ENTRY AND HOW MANY OF THEM WERE EMITTED
+	uint16_t*				chain;
+	uint32_t				clusters;
+	uint32_t				emitted;
+	uint32_t				expected;
+	int 					ended;
+	// CHAIN STOPPED BEFORE AN END OF CHAIN MARK
+	int 					broken;
+};
+struct stream_ctx_t {
+	FILE*					stream;
+	struct bpb_t			bpb;
+	uint8_t*				fat;
+	size_t					fat_size;
+	uint32_t				cluster_size;
+	uint32_t				clusters;
+
+	// PER CLUSTER: NODE ID + 1, POSITION IN ITS CHAIN AND DATA READ TOO EARLY
+	uint32_t*				owners;
+	uint32_t*				positions;
+	uint8_t**				pending;
+
+	struct stream_node_t*	nodes;
+	uint32_t				size;
+	uint32_t				capacity;
+
+	extract_callback_t		callback;
+	void*					arg;
+	int 					error;
+	// ENTRIES LEFT OUT, E.G. DIRS POINTING INTO A CHAIN SEEN BEFORE
+	int 					skipped;
+};
+
+static int parse_dir(struct stream_ctx_t* ctx, uint32_t id, const uint8_t* data, uint32_t entries);
+
+static int stream_skip(FILE* stream, size_t bytes) {
+	uint8_t scratch[BLOCK_SIZE];
+	while (bytes > 0) {
+		size_t chunk = bytes < sizeof(scratch) ? bytes : sizeof(scratch);
+		if (fread(scratch, 1, chunk, stream) != chunk) {
+			return -1;
+		}
+		bytes -= chunk;
+	}
+	return 0;
+}
+static int emit_cluster(struct stream_ctx_t* ctx, uint32_t id, const uint8_t* data) {
+	struct stream_node_t *node = ctx->nodes + id - 1;
+	uint32_t position = node->emitted++;
+	if (node->entry.is_directory) {
+		if (node->ended) {
+			return 0;
+		}
+		return parse_dir(ctx, id, data, ctx->cluster_size / FAT_RECORD_SIZE);
+	}
+	uint32_t offset = position * ctx->cluster_size;
+	uint32_t size = node->entry.size - offset < ctx->cluster_size ? node->entry.size - offset : ctx->cluster_size;
+	if (ctx->callback(&node->entry, offset, data, size, ctx->arg) != 0) {
+		ctx->error = ECANCELED;
+		return -1;
+	}
+	return 0;
+}
+// EMIT EVERYTHING THAT WAS WAITING FOR ITS TURN
+static int drain_node(struct stream_ctx_t* ctx, uint32_t id) {
+	while (1) {
+		struct stream_node_t *node = ctx->nodes + id - 1;
+		if (node->emitted == node->clusters) {
+			return 0;
+		}
+		uint16_t cluster = *(node->chain + node->emitted);
+		uint8_t *data = *(ctx->pending + cluster);
+		if (data == NULL) {
+			return 0;
+		}
+		*(ctx->pending + cluster) = NULL;
+		int ret = emit_cluster(ctx, id, data);
+		free(data);
+		if (ret != 0) {
+			return ret;
+		}
+	}
+}
+static int register_node(struct stream_ctx_t* ctx, const char* parent_path, struct actual_dir_entry_t* ent) {
+	uint16_t cluster = ent->DIR_FstClusLO;
+	int is_directory = ent->DIR_Attr.ATTR_DIRECTORY;
+	// DIR ALREADY SEEN, DO NOT LOOP
+	if (is_directory && (cluster < 2 || cluster >= ctx->clusters || *(ctx->owners + cluster) != 0)) {
+		ctx->skipped = 1;
+		return 0;
+	}
+	// GROW ARRAY
+	if (ctx->size == ctx->capacity) {
+		uint32_t capacity = ctx->capacity ? ctx->capacity * 2 : 64;
+		struct stream_node_t *nodes = realloc(ctx->nodes, capacity * sizeof(struct stream_node_t));
+		if (nodes == NULL) {
+			ctx->error = ENOMEM;
+			return -1;
+		}
+		ctx->nodes = nodes;
+		ctx->capacity = capacity;
+	}
+	struct stream_node_t *node = ctx->nodes + ctx->size;
+	memset(node, 0, sizeof(struct stream_node_t));
+	convert_entry_name(*ent, node->entry.name);
+	node->path = malloc(strlen(parent_path) + strlen(node->entry.name) + 2);
+	node->expected = is_directory ? ctx->clusters : (ent->DIR_FileSize + ctx->cluster_size - 1) / ctx->cluster_size;
+	node->chain = malloc((node->expected ? node->expected : 1) * sizeof(uint16_t));
+	if (node->path == NULL || node->chain == NULL) {
+		free(node->path);
+		free(node->chain);
+		ctx->error = ENOMEM;
+		return -1;
+	}
+	sprintf(node->path, "%s\\%s", parent_path, node->entry.name);
+	node->entry.path = node->path;
+	node->entry.size = is_directory ? 0 : ent->DIR_FileSize;
+	node->entry.is_directory = is_directory;
+	node->entry.cluster_number = cluster;
+	uint32_t id = ++ctx->size;
+
+	// SCHEDULE CHAIN, CLUSTERS OWNED BY SOMEONE ELSE END IT
+	while (node->clusters < node->expected && cluster >= 2 && cluster < ctx->clusters && *(ctx->owners + cluster) == 0) {
+		*(ctx->owners + cluster) = id;
+		*(ctx->positions + cluster) = node->clusters;
+		*(node->chain + node->clusters++) = cluster;
+		cluster = get_fat12_entry(ctx->fat, ctx->fat_size, cluster);
+	}
+	// LOOP, CLUSTER OF ANOTHER ENTRY, FREE OR BAD CLUSTER
+	if (node->clusters < node->expected && cluster < 0x0FF8) {
+		node->broken = 1;
+	}
+	if (is_directory) {
+		node->expected = node->clusters;
+	}
+	if (ctx->callback(&node->entry, 0, NULL, 0, ctx->arg) != 0) {
+		ctx->error = ECANCELED;
+		return -1;
+	}
+	return drain_node(ctx, id);
+}
+static int parse_dir(struct stream_ctx_t* ctx, uint32_t id, const uint8_t* data, uint32_t entries) {
+	// ROOT HAS NO NODE
+	const char *path = id == 0 ? "" : (ctx->nodes + id - 1)->path;
+	for (uint32_t i = 0; i < entries; ++i) {
+		struct actual_dir_entry_t ent;
+		memcpy(&ent, data + i * FAT_RECORD_SIZE, sizeof(ent));
+		// END OF DIR
+		if (ent.DIR_Name[0] == 0x00) {
+			if (id != 0) {
+				(ctx->nodes + id - 1)->ended = 1;
+			}
+			return 0;
+		}
+		// SKIP FREE ENTRIES, VOLUME LABELS, LONG NAMES AND DOT ENTRIES
+		if (ent.DIR_Name[0] == 0xE5 || ent.DIR_Attr.ATTR_VOLUME_ID || ent.DIR_Name[0] == '.') {
+			continue;
+		}
+		// DIR[0] IS A KANJI
+		if (ent.DIR_Name[0] == 0x05) {
+			ent.DIR_Name[0] = 0xE5;
+		}
+		if (register_node(ctx, path, &ent) != 0) {
+			return -1;
+		}
+		// NODES MAY HAVE MOVED
+		path = id == 0 ? "" : (ctx->nodes + id - 1)->path;
+	}
+	return 0;
+}
+static int stream_run(struct stream_ctx_t* ctx) {
+	struct bpb_t bpb = ctx->bpb;
+	// FAT 1
+	if (stream_skip(ctx->stream, fat1_addr(bpb) - BLOCK_SIZE) != 0 || fread(ctx->fat, 1, ctx->fat_size, ctx->stream) != ctx->fat_size) {
+		ctx->error = EIO;
+		return -1;
+	}
+	// OTHER FATS ARE NOT NEEDED
+	if (stream_skip(ctx->stream, root_addr(bpb) - fat1_addr(bpb) - ctx->fat_size) != 0) {
+		ctx->error = EIO;
+		return -1;
+	}
+	// ROOT DIR
+	size_t RootSize = bpb.BPB_RootEntCnt * FAT_RECORD_SIZE;
+	uint8_t *buffer = malloc(RootSize > ctx->cluster_size ? RootSize : ctx->cluster_size);
+	if (buffer == NULL) {
+		ctx->error = ENOMEM;
+		return -1;
+	}
+	if (fread(buffer, 1, RootSize, ctx->stream) != RootSize) {
+		free(buffer);
+		ctx->error = EIO;
+		return -1;
+	}
+	if (parse_dir(ctx, 0, buffer, bpb.BPB_RootEntCnt) != 0) {
+		free(buffer);
+		return -1;
+	}
+	// NOTHING PAST LAST ALLOCATED CLUSTER IS NEEDED
+	uint32_t last = 1;
+	for (uint32_t cluster = 2; cluster < ctx->clusters; ++cluster) {
+		uint16_t value = get_fat12_entry(ctx->fat, ctx->fat_size, cluster);
+		if (value != 0x0000 && value != 0x0FF7) {
+			last = cluster;
+		}
+	}
+	// DATA IN DISK ORDER
+	for (uint32_t cluster = 2; cluster <= last; ++cluster) {
+		if (fread(buffer, 1, ctx->cluster_size, ctx->stream) != ctx->cluster_size) {
+			free(buffer);
+			ctx->error = EIO;
+			return -1;
+		}
+		uint32_t id = *(ctx->owners + cluster);
+		// ITS TURN, NO NEED TO BUFFER
+		if (id != 0 && (ctx->nodes + id - 1)->emitted == *(ctx->positions + cluster)) {
+			if (emit_cluster(ctx, id, buffer) != 0 || drain_node(ctx, id) != 0) {
+				free(buffer);
+				return -1;
+			}
+			continue;
+		}
+		// OWNER NOT KNOWN YET OR TOO EARLY
+		uint16_t value = get_fat12_entry(ctx->fat, ctx->fat_size, cluster);
+		if (id != 0 || (value != 0x0000 && value != 0x0FF7)) {
+			uint8_t *data = malloc(ctx->cluster_size);
+			if (data == NULL) {
+				free(buffer);
+				ctx->error = ENOMEM;
+				return -1;
+			}
+			memcpy(data, buffer, ctx->cluster_size);
+			*(ctx->pending + cluster) = data;
+		}
+	}
+	free(buffer);
+	// BROKEN CHAINS, ENTRIES STORED PAST THEM WERE NOT EXTRACTED
+	if (ctx->skipped) {
+		ctx->error = EIO;
+		return -1;
+	}
+	for (uint32_t i = 0; i < ctx->size; ++i) {
+		struct stream_node_t *node = ctx->nodes + i;
+		if (node->broken || node->emitted != node->expected) {
+			ctx->error = EIO;
+			return -1;
+		}
+	}
+	return 0;
+}
+int disk_extract_stream(FILE* stream, extract_callback_t callback, void* arg) {
+	if (stream == NULL || callback == NULL) {
+		errno = EFAULT;
+		return -1;
+	}
+	struct stream_ctx_t ctx;
+	memset(&ctx, 0, sizeof(ctx));
+	ctx.stream = stream;
+	ctx.callback = callback;
+	ctx.arg = arg;
+
+	// BOOT SECTOR
+	if (fread(&ctx.bpb, 1, BLOCK_SIZE, stream) != BLOCK_SIZE) {
+		errno = EIO;
+		return -1;
+	}
+	if (fat_check_bpb(ctx.bpb) != 0) {
+		return -1;
+	}
+	ctx.fat_size = ctx.bpb.BPB_BytsPerSec * ctx.bpb.BPB_FATSz16;
+	ctx.cluster_size = ctx.bpb.BPB_BytsPerSec * ctx.bpb.BPB_SecPerClus;
+	ctx.clusters = data_clusters(ctx.bpb) + 2;
+	ctx.fat = malloc(ctx.fat_size);
+	ctx.owners = calloc(ctx.clusters, sizeof(uint32_t));
+	ctx.positions = calloc(ctx.clusters, sizeof(uint32_t));
+	ctx.pending = calloc(ctx.clusters, sizeof(uint8_t *));
+
+	int ret = -1;
+	if (ctx.fat == NULL || ctx.owners == NULL || ctx.positions == NULL || ctx.pending == NULL) {
+		ctx.error = ENOMEM;
+	} else {
+		ret = stream_run(&ctx);
+	}
+	// CLEAN UP
+	for (uint32_t i = 0; ctx.pending != NULL && i < ctx.clusters; ++i) {
+		free(*(ctx.pending + i));
+	}
+	for (uint32_t i = 0; i < ctx.size; ++i) {
+		free((ctx.nodes + i)->path);
+		free((ctx.nodes + i)->chain);
+	}
+	free(ctx.nodes);
+	free(ctx.pending);
+	free(ctx.positions);
+	free(ctx.owners);
+	free(ctx.fat);
+	if (ret != 0) {
+		errno = ctx.error;
+	}
+	return ret;
+}
@@ -0,0 +1,20 @@
+#ifndef __STREAM_EXTRACT_H__
+#define __STREAM_EXTRACT_H__
+
+#include "file_reader.h"
+
+struct extract_entry_t {
+	const char*			path;
+	char 				name[13];
+	uint32_t 			size;
+	int 				is_directory;
+	uint16_t			cluster_number;
+};
+
+// CALLED ONCE WITH NO DATA WHEN AN ENTRY IS FOUND, THEN WITH ITS DATA IN ORDER
+typedef int (*extract_callback_t)(const struct extract_entry_t* pentry, uint32_t offset, const void* data, uint32_t size, void* arg);
+
+// STREAMING
+int disk_extract_stream(FILE* stream, extract_callback_t callback, void* arg);
+
+#endif
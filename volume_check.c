@@ -0,0 +1,497 @@
+#include "volume_check.h"
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <stdatomic.h>
+
+#define CHECK_MAX_THREADS   64
+
+struct check_job_t {
+	char*				path;
+	uint16_t			cluster;
+	struct check_job_t*	next;
+};
+// CHAIN WALKED BY A WORKER, CROSS-LINKS AND SIZES ARE JUDGED ONCE ALL WORKERS ARE DONE
+struct check_chain_t {
+	char*				path;
+	uint16_t			cluster;
+	uint32_t			length;
+
+	// FILES ONLY, IN CLUSTERS
+	int 				sized;
+	uint32_t			expected;
+};
+struct check_ctx_t {
+	struct volume_t*		pvolume;
+	struct check_result_t*	presult;
+	uint32_t				clusters;
+	size_t					fat_size;
+	uint32_t				cluster_size;
+
+	// ONE BIT PER CLUSTER, SHARED BY ALL WORKERS
+	_Atomic uint32_t*		bitmap;
+	// CLUSTERS CLAIMED BY MORE THAN ONE CHAIN
+	_Atomic uint32_t*		shared;
+
+	// PENDING DIRS, COUNT INCLUDES THOSE BEING CHECKED
+	pthread_mutex_t			lock;
+	pthread_cond_t			cond;
+	struct check_job_t*		queue;
+	uint32_t				pending;
+
+	pthread_mutex_t			result_lock;
+	_Atomic int				error;
+};
+struct check_worker_t {
+	struct check_ctx_t*		ctx;
+	pthread_t				thread;
+
+	// CLUSTERS VISITED BY CURRENT CHAIN
+	uint16_t*				stamps;
+	uint16_t				stamp;
+
+	struct check_chain_t*	chains;
+	uint32_t				chains_size;
+	uint32_t				chains_capacity;
+
+	uint32_t				files;
+	uint32_t				directories;
+};
+
+static void add_problem(struct check_ctx_t* ctx, int type, const char* path, uint16_t cluster, uint32_t expected, uint32_t actual) {
+	pthread_mutex_lock(&ctx->result_lock);
+	struct check_result_t *presult = ctx->presult;
+	// GROW ARRAY
+	if (presult->size == presult->capacity) {
+		uint32_t capacity = presult->capacity ? presult->capacity * 2 : 16;
+		struct check_problem_t *problems = realloc(presult->problems, capacity * sizeof(struct check_problem_t));
+		if (problems == NULL) {
+			ctx->error = ENOMEM;
+			pthread_mutex_unlock(&ctx->result_lock);
+			return;
+		}
+		presult->problems = problems;
+		presult->capacity = capacity;
+	}
+	struct check_problem_t *problem = presult->problems + presult->size;
+	problem->path = NULL;
+	if (path != NULL) {
+		problem->path = malloc(strlen(path) + 1);
+		if (problem->path == NULL) {
+			ctx->error = ENOMEM;
+			pthread_mutex_unlock(&ctx->result_lock);
+			return;
+		}
+		strcpy(problem->path, path);
+	}
+	problem->type = type;
+	problem->cluster = cluster;
+	problem->expected = expected;
+	problem->actual = actual;
+	presult->size++;
+	pthread_mutex_unlock(&ctx->result_lock);
+}
+static int push_job(struct check_ctx_t* ctx, const char* path, uint16_t cluster) {
+	struct check_job_t *job = malloc(sizeof(struct check_job_t));
+	if (job == NULL) {
+		return -1;
+	}
+	job->path = malloc(strlen(path) + 1);
+	if (job->path == NULL) {
+		free(job);
+		return -1;
+	}
+	strcpy(job->path, path);
+	job->cluster = cluster;
+
+	pthread_mutex_lock(&ctx->lock);
+	job->next = ctx->queue;
+	ctx->queue = job;
+	ctx->pending++;
+	pthread_cond_signal(&ctx->cond);
+	pthread_mutex_unlock(&ctx->lock);
+	return 0;
+}
+static void add_chain(struct check_worker_t* worker, const char* path, uint16_t cluster, uint32_t length, int sized, uint32_t expected) {
+	// GROW ARRAY
+	if (worker->chains_size == worker->chains_capacity) {
+		uint32_t capacity = worker->chains_capacity ? worker->chains_capacity * 2 : 64;
+		struct check_chain_t *chains = realloc(worker->chains, capacity * sizeof(struct check_chain_t));
+		if (chains == NULL) {
+			worker->ctx->error = ENOMEM;
+			return;
+		}
+		worker->chains = chains;
+		worker->chains_capacity = capacity;
+	}
+	struct check_chain_t *chain = worker->chains + worker->chains_size;
+	chain->path = malloc(strlen(path) + 1);
+	if (chain->path == NULL) {
+		worker->ctx->error = ENOMEM;
+		return;
+	}
+	strcpy(chain->path, path);
+	chain->cluster = cluster;
+	chain->length = length;
+	chain->sized = sized;
+	chain->expected = expected;
+	worker->chains_size++;
+}
+// RETURNS CHAIN LENGTH, SETS FRESH IF FIRST CLUSTER WAS NOT CLAIMED BEFORE
+static uint32_t check_chain(struct check_worker_t* worker, const char* path, uint16_t cluster, int* fresh, int* broken) {
+	struct check_ctx_t *ctx = worker->ctx;
+	uint32_t len = 0;
+	*fresh = 0;
+	*broken = 1;
+
+	// NEW STAMP FOR EVERY CHAIN
+	if (++worker->stamp == 0) {
+		memset(worker->stamps, 0, ctx->clusters * sizeof(uint16_t));
+		worker->stamp = 1;
+	}
+	if (cluster < 2 || cluster >= ctx->clusters) {
+		add_problem(ctx, CHECK_INVALID_CLUSTER, path, cluster, 0, cluster);
+		return 0;
+	}
+	while (1) {
+		if (*(worker->stamps + cluster) == worker->stamp) {
+			add_problem(ctx, CHECK_CHAIN_LOOP, path, cluster, 0, len);
+			return len;
+		}
+		*(worker->stamps + cluster) = worker->stamp;
+
+		// CLAIM CLUSTER
+		uint32_t bit = 1u << (cluster % 32);
+		uint32_t old = atomic_fetch_or(ctx->bitmap + cluster / 32, bit);
+		if (old & bit) {
+			atomic_fetch_or(ctx->shared + cluster / 32, bit);
+		} else if (len == 0) {
+			*fresh = 1;
+		}
+		len++;
+
+		uint16_t next = get_fat12_entry(ctx->pvolume->FAT1, ctx->fat_size, cluster);
+		// LAST CLUSTER IN CHAIN
+		if (next >= 0x0FF8) {
+			break;
+		}
+		if (next == 0x0000) {
+			add_problem(ctx, CHECK_FREE_IN_CHAIN, path, cluster, 0, len);
+			return len;
+		}
+		if (next == 0x0FF7) {
+			add_problem(ctx, CHECK_BAD_IN_CHAIN, path, cluster, 0, len);
+			return len;
+		}
+		if (next < 2 || next >= ctx->clusters) {
+			add_problem(ctx, CHECK_INVALID_CLUSTER, path, cluster, 0, next);
+			return len;
+		}
+		cluster = next;
+	}
+	*broken = 0;
+	return len;
+}
+static void check_dir(struct check_worker_t* worker, struct check_job_t* job) {
+	struct check_ctx_t *ctx = worker->ctx;
+	uint32_t entries = 0;
+	struct actual_dir_entry_t *buffer = dir_load(ctx->pvolume, job->cluster, &entries);
+	if (buffer == NULL) {
+		add_problem(ctx, CHECK_DIR_UNREADABLE, job->path[0] ? job->path : "\\", job->cluster, 0, 0);
+		return;
+	}
+	char *path = malloc(strlen(job->path) + 14);
+	if (path == NULL) {
+		ctx->error = ENOMEM;
+		free(buffer);
+		return;
+	}
+	for (uint32_t i = 0; i < entries; ++i) {
+		struct actual_dir_entry_t ent = *(buffer + i);
+		// END OF DIR
+		if (ent.DIR_Name[0] == 0x00) {
+			break;
+		}
+		// SKIP FREE ENTRIES, VOLUME LABELS, LONG NAMES AND DOT ENTRIES
+		if (ent.DIR_Name[0] == 0xE5 || ent.DIR_Attr.ATTR_VOLUME_ID || ent.DIR_Name[0] == '.') {
+			continue;
+		}
+		// DIR[0] IS A KANJI
+		if (ent.DIR_Name[0] == 0x05) {
+			ent.DIR_Name[0] = 0xE5;
+		}
+		char name[13];
+		convert_entry_name(ent, name);
+		sprintf(path, "%s\\%s", job->path, name);
+
+		int fresh = 0;
+		int broken = 0;
+		uint16_t cluster = ent.DIR_FstClusLO;
+		if (ent.DIR_Attr.ATTR_DIRECTORY) {
+			worker->directories++;
+			uint32_t len = check_chain(worker, path, cluster, &fresh, &broken);
+			add_chain(worker, path, cluster, len, 0, 0);
+			if (ent.DIR_FileSize != 0) {
+				add_problem(ctx, CHECK_SIZE_MISMATCH, path, cluster, 0, ent.DIR_FileSize);
+			}
+			// DESCEND ONLY INTO DIRS NOBODY ELSE CLAIMED
+			if (fresh && push_job(ctx, path, cluster) != 0) {
+				ctx->error = ENOMEM;
+			}
+			continue;
+		}
+		worker->files++;
+		uint32_t expected = (ent.DIR_FileSize + ctx->cluster_size - 1) / ctx->cluster_size;
+		// EMPTY FILE WITHOUT CLUSTERS
+		if (expected == 0 && cluster == 0) {
+			continue;
+		}
+		uint32_t len = check_chain(worker, path, cluster, &fresh, &broken);
+		add_chain(worker, path, cluster, len, !broken, expected);
+	}
+	free(path);
+	free(buffer);
+}
+static void* check_worker(void* arg) {
+	struct check_worker_t *worker = (struct check_worker_t *)arg;
+	struct check_ctx_t *ctx = worker->ctx;
+	while (1) {
+		pthread_mutex_lock(&ctx->lock);
+		while (ctx->queue == NULL && ctx->pending > 0) {
+			pthread_cond_wait(&ctx->cond, &ctx->lock);
+		}
+		// NOTHING QUEUED AND NOTHING BEING CHECKED
+		if (ctx->queue == NULL) {
+			pthread_mutex_unlock(&ctx->lock);
+			break;
+		}
+		struct check_job_t *job = ctx->queue;
+		ctx->queue = job->next;
+		pthread_mutex_unlock(&ctx->lock);
+
+		check_dir(worker, job);
+		free(job->path);
+		free(job);
+
+		pthread_mutex_lock(&ctx->lock);
+		if (--ctx->pending == 0) {
+			pthread_cond_broadcast(&ctx->cond);
+		}
+		pthread_mutex_unlock(&ctx->lock);
+	}
+	return NULL;
+}
+static int compare_problems(const void* a, const void* b) {
+	const struct check_problem_t *pa = (const struct check_problem_t *)a;
+	const struct check_problem_t *pb = (const struct check_problem_t *)b;
+	if (pa->type != pb->type) {
+		return pa->type - pb->type;
+	}
+	if (pa->path != NULL && pb->path != NULL) {
+		int ret = strcmp(pa->path, pb->path);
+		if (ret != 0) {
+			return ret;
+		}
+	}
+	if (pa->cluster != pb->cluster) {
+		return pa->cluster - pb->cluster;
+	}
+	if (pa->expected != pb->expected) {
+		return pa->expected < pb->expected ? -1 : 1;
+	}
+	return pa->actual < pb->actual ? -1 : pa->actual > pb->actual;
+}
+// EVERY CHAIN THROUGH A SHARED CLUSTER IS REPORTED, SO THE RESULT DOES NOT DEPEND ON WHICH WORKER CAME FIRST
+static void judge_chain(struct check_ctx_t* ctx, const struct check_chain_t* chain) {
+	uint16_t cluster = chain->cluster;
+	for (uint32_t i = 0; i < chain->length; ++i) {
+		if (atomic_load(ctx->shared + cluster / 32) & (1u << (cluster % 32))) {
+			add_problem(ctx, CHECK_CROSSLINKED, chain->path, cluster, 0, i);
+			return;
+		}
+		cluster = get_fat12_entry(ctx->pvolume->FAT1, ctx->fat_size, cluster);
+	}
+	if (chain->sized && chain->length != chain->expected) {
+		add_problem(ctx, CHECK_SIZE_MISMATCH, chain->path, chain->cluster, chain->expected, chain->length);
+	}
+}
+struct check_result_t* volume_check(struct volume_t* pvolume, int threads) {
+	if (pvolume == NULL || pvolume->FAT1 == NULL) {
+		errno = EFAULT;
+		return NULL;
+	}
+	if (threads < 1) {
+		long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+		threads = cpus > 0 ? (int)cpus : 1;
+	}
+	if (threads > CHECK_MAX_THREADS) {
+		threads = CHECK_MAX_THREADS;
+	}
+	struct check_result_t *presult = calloc(1, sizeof(struct check_result_t));
+	if (presult == NULL) {
+		errno = ENOMEM;
+		return NULL;
+	}
+	struct check_ctx_t ctx;
+	memset(&ctx, 0, sizeof(ctx));
+	ctx.pvolume = pvolume;
+	ctx.presult = presult;
+	ctx.clusters = data_clusters(pvolume->bpb) + 2;
+	ctx.fat_size = pvolume->bpb.BPB_BytsPerSec * pvolume->bpb.BPB_FATSz16;
+	ctx.cluster_size = pvolume->bpb.BPB_BytsPerSec * pvolume->bpb.BPB_SecPerClus;
+	ctx.bitmap = calloc((ctx.clusters + 31) / 32, sizeof(uint32_t));
+	ctx.shared = calloc((ctx.clusters + 31) / 32, sizeof(uint32_t));
+
+	struct check_worker_t *workers = calloc(threads, sizeof(struct check_worker_t));
+	if (ctx.bitmap == NULL || ctx.shared == NULL || workers == NULL) {
+		free((void *)ctx.bitmap);
+		free((void *)ctx.shared);
+		free(workers);
+		free(presult);
+		errno = ENOMEM;
+		return NULL;
+	}
+	for (int i = 0; i < threads; ++i) {
+		(workers + i)->ctx = &ctx;
+		(workers + i)->stamps = calloc(ctx.clusters, sizeof(uint16_t));
+		if ((workers + i)->stamps == NULL) {
+			for (int j = 0; j <= i; ++j) {
+				free((workers + j)->stamps);
+			}
+			free((void *)ctx.bitmap);
+			free((void *)ctx.shared);
+			free(workers);
+			free(presult);
+			errno = ENOMEM;
+			return NULL;
+		}
+	}
+	pthread_mutex_init(&ctx.lock, NULL);
+	pthread_cond_init(&ctx.cond, NULL);
+	pthread_mutex_init(&ctx.result_lock, NULL);
+
+	// MEDIA BYTE IS REPEATED IN FIRST FAT ENTRY
+	uint16_t media = get_fat12_entry(pvolume->FAT1, ctx.fat_size, 0);
+	if ((media & 0xFF) != pvolume->bpb.BPB_Media) {
+		add_problem(&ctx, CHECK_MEDIA_MISMATCH, NULL, 0, pvolume->bpb.BPB_Media, media & 0xFF);
+	}
+	// EVERY CLUSTER WHOSE ENTRY DIFFERS BETWEEN THE COPIES
+	if (pvolume->bpb.BPB_NumFATs > 1 && pvolume->FAT2 != NULL) {
+		for (uint16_t cluster = 0; cluster < ctx.clusters; ++cluster) {
+			uint16_t first = get_fat12_entry(pvolume->FAT1, ctx.fat_size, cluster);
+			uint16_t second = get_fat12_entry(pvolume->FAT2, ctx.fat_size, cluster);
+			if (first != second) {
+				add_problem(&ctx, CHECK_FAT_MISMATCH, NULL, cluster, first, second);
+			}
+		}
+	}
+
+	// CALLING THREAD WORKS TOO
+	int started = 1;
+	if (push_job(&ctx, "", 0) != 0) {
+		ctx.error = ENOMEM;
+	} else {
+		for (; started < threads; ++started) {
+			if (pthread_create(&(workers + started)->thread, NULL, check_worker, workers + started) != 0) {
+				break;
+			}
+		}
+		check_worker(workers);
+		for (int i = 1; i < started; ++i) {
+			pthread_join((workers + i)->thread, NULL);
+		}
+	}
+	for (int i = 0; i < threads; ++i) {
+		struct check_worker_t *worker = workers + i;
+		presult->files += worker->files;
+		presult->directories += worker->directories;
+		for (uint32_t j = 0; j < worker->chains_size; ++j) {
+			judge_chain(&ctx, worker->chains + j);
+			free((worker->chains + j)->path);
+		}
+		free(worker->chains);
+		free(worker->stamps);
+	}
+	free(workers);
+
+	// ALLOCATED BUT NOT CLAIMED BY ANY CHAIN
+	for (uint16_t cluster = 2; cluster < ctx.clusters; ++cluster) {
+		if (atomic_load(ctx.bitmap + cluster / 32) & (1u << (cluster % 32))) {
+			presult->used_clusters++;
+			continue;
+		}
+		uint16_t value = get_fat12_entry(pvolume->FAT1, ctx.fat_size, cluster);
+		if (value != 0x0000 && value != 0x0FF7) {
+			add_problem(&ctx, CHECK_LOST_CLUSTER, NULL, cluster, 0, value);
+		}
+	}
+	pthread_mutex_destroy(&ctx.lock);
+	pthread_cond_destroy(&ctx.cond);
+	pthread_mutex_destroy(&ctx.result_lock);
+	free((void *)ctx.bitmap);
+	free((void *)ctx.shared);
+
+	if (ctx.error != 0) {
+		check_result_free(presult);
+		errno = ctx.error;
+		return NULL;
+	}
+	// WORKERS FINISH IN ANY ORDER
+	if (presult->size > 0) {
+		qsort(presult->problems, presult->size, sizeof(struct check_problem_t), compare_problems);
+	}
+	return presult;
+}
+int check_result_free(struct check_result_t* presult) {
+	if (presult == NULL) {
+		errno = EFAULT;
+		return -1;
+	}
+	for (uint32_t i = 0; i < presult->size; ++i) {
+		free((presult->problems + i)->path);
+	}
+	free(presult->problems);
+	free(presult);
+	return 0;
+}
+const char* check_problem_str(int type) {
+	switch(type) {
+		case CHECK_MEDIA_MISMATCH:
+			return "media byte mismatch";
+		case CHECK_DIR_UNREADABLE:
+			return "unreadable directory";
+		case CHECK_INVALID_CLUSTER:
+			return "invalid cluster";
+		case CHECK_FREE_IN_CHAIN:
+			return "free cluster in chain";
+		case CHECK_BAD_IN_CHAIN:
+			return "bad cluster in chain";
+		case CHECK_CHAIN_LOOP:
+			return "chain loop";
+		case CHECK_CROSSLINKED:
+			return "cross-linked cluster";
+		case CHECK_SIZE_MISMATCH:
+			return "size mismatch";
+		case CHECK_LOST_CLUSTER:
+			return "lost cluster";
+		case CHECK_FAT_MISMATCH:
+			return "FAT copies differ";
+		default:
+			return "unknown";
+	}
+}
+void print_check_result(const struct check_result_t* presult) {
+	if (presult == NULL) {
+		return;
+	}
+	printf("Files: %u\n", presult->files);
+	printf("Directories: %u\n", presult->directories);
+	printf("Used clusters: %u\n", presult->used_clusters);
+	printf("Problems: %u\n", presult->size);
+	for (uint32_t i = 0; i < presult->size; ++i) {
+		const struct check_problem_t *problem = presult->problems + i;
+		printf("\t%-22s | %-24s | cluster %4hu | expected %u, actual %u\n", check_problem_str(problem->type), problem->path ? problem->path : "-", problem->cluster, problem->expected, problem->actual);
+	}
+}
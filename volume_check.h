@@ -0,0 +1,45 @@
+#ifndef __VOLUME_CHECK_H__
+#define __VOLUME_CHECK_H__
+
+#include "file_reader.h"
+
+// PROBLEM TYPES
+#define CHECK_MEDIA_MISMATCH    1
+#define CHECK_DIR_UNREADABLE    2
+#define CHECK_INVALID_CLUSTER   3
+#define CHECK_FREE_IN_CHAIN     4
+#define CHECK_BAD_IN_CHAIN      5
+#define CHECK_CHAIN_LOOP        6
+#define CHECK_CROSSLINKED       7
+#define CHECK_SIZE_MISMATCH     8
+#define CHECK_LOST_CLUSTER      9
+#define CHECK_FAT_MISMATCH      10
+
+struct check_problem_t {
+	int 				type;
+	char*				path;
+	uint16_t			cluster;
+
+	// MEANING DEPENDS ON TYPE, E.G. SIZE IN CLUSTERS
+	uint32_t			expected;
+	uint32_t			actual;
+};
+struct check_result_t {
+	struct check_problem_t*	problems;
+	uint32_t				size;
+	uint32_t				capacity;
+
+	uint32_t				files;
+	uint32_t				directories;
+	uint32_t				used_clusters;
+};
+
+// CHECKING
+struct check_result_t* volume_check(struct volume_t* pvolume, int threads);
+int check_result_free(struct check_result_t* presult);
+const char* check_problem_str(int type);
+
+// PRINTING
+void print_check_result(const struct check_result_t* presult);
+
+#endif